@@ -0,0 +1,99 @@
+// Compare threads allocating small blocks from a shared arena: a
+// 'monotonic_buffer_resource' behind a mutex, a 'synchronized_pool_resource'
+// and a 'concurrent_monotonic_resource', from 1 to N threads, N being the
+// number of hardware threads, at least 4.  The times are per allocation,
+// all threads together: a resource that scales keeps them falling.
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <concurrent_monotonic_resource.h>
+
+#include <supportlib/stopwatch.h>
+
+constexpr long long iterations = 8000000;
+
+class locked_monotonic_resource final : public std::pmr::memory_resource {
+    // A 'monotonic_buffer_resource' made thread safe the simple way.
+
+    std::mutex                          m_lock_;
+    std::pmr::monotonic_buffer_resource m_monotonic_;
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        std::lock_guard<std::mutex> guard{ m_lock_ };
+        return m_monotonic_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *, size_t, size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+};
+
+void allocateBlocks(std::pmr::memory_resource *resource, long long count)
+{
+    for (long long i = 0; i < count; ++i) {
+        void *block = resource->allocate(32, 8);
+        do_not_optimize(block);
+    }
+}
+
+template <class RESOURCE>
+void benchmark(const char *name, int threadCount)
+{
+    RESOURCE resource;
+
+    Stopwatch stopwatch;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back(allocateBlocks,
+                             &resource,
+                             iterations / threadCount);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    char label[80];
+    std::snprintf(label, sizeof label, "%d threads, %s", threadCount, name);
+    report(label, stopwatch.elapsed_ns(), iterations);
+}
+
+int main()
+{
+    const int maxThreads = std::max(4u, std::thread::hardware_concurrency());
+
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        benchmark<locked_monotonic_resource>("locked monotonic", threadCount);
+        benchmark<std::pmr::synchronized_pool_resource>("synchronized pool",
+                                                        threadCount);
+        benchmark<concurrent_monotonic_resource>("concurrent monotonic",
+                                                 threadCount);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,81 @@
+// Compare random reads over a large 'std::pmr::vector' allocated from the
+// default resource with the same vector allocated from a
+// 'huge_page_resource', with huge pages and with normal pages.  Random
+// access over more memory than the TLB covers with normal pages misses the
+// TLB on nearly every read; with huge pages, far less often.
+
+#include <memory_resource_p1160>
+#include <cstdint>
+#include <cstdio>
+
+#include <huge_page_resource.h>
+
+#include <supportlib/stopwatch.h>
+
+constexpr size_t    elementCount = size_t(32) << 20;   // 256 MiB
+constexpr long long reads        = 20000000;
+
+void randomReads(const char *name, std::pmr::memory_resource *resource)
+{
+    std::pmr::vector<std::uint64_t> values{ resource };
+    values.resize(elementCount);
+    for (size_t i = 0; i < elementCount; ++i) {
+        values[i] = i;
+    }
+
+    // A xorshift generator: cheap next to a cache miss.
+
+    std::uint64_t state = 88172645463325252ull;
+    std::uint64_t sum   = 0;
+
+    Stopwatch stopwatch;
+    for (long long i = 0; i < reads; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        sum += values[state % elementCount];
+    }
+    report(name, stopwatch.elapsed_ns(), reads);
+    do_not_optimize(sum);
+}
+
+const char *kindName(huge_page_resource::page_kind kind)
+{
+    switch (kind) {
+      case huge_page_resource::page_kind::huge:        return "huge";
+      case huge_page_resource::page_kind::transparent: return "transparent";
+      case huge_page_resource::page_kind::normal:      return "normal";
+    }
+    return "unknown";
+}
+
+int main()
+{
+    randomReads("default resource", std::pmr::get_default_resource());
+
+    {
+        huge_page_resource normal{ huge_page_resource::page_kind::normal };
+        randomReads("huge_page_resource, normal pages", &normal);
+    }
+
+    huge_page_resource huge;
+    randomReads("huge_page_resource", &huge);
+    std::printf("%-40s %s pages\n",
+                "huge_page_resource", kindName(huge.kind()));
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
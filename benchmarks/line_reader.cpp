@@ -0,0 +1,122 @@
+// Compare reading the lines of a file with 'std::getline' into
+// 'std::pmr::string' objects with the memory mapped 'pstring_line_reader'.
+
+#include <memory_resource_p1160>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <pstring_lines.h>
+
+#include <supportlib/stopwatch.h>
+
+constexpr long long lineCount = 1000000;
+constexpr size_t    batchSize = 65536;
+
+struct TempFile {
+    // Create a file of 'lineCount' symbols, removed on destruction.
+
+    char m_path_[32] = "/tmp/line_reader_XXXXXX";
+
+    TempFile()
+    {
+        const int fd = ::mkstemp(m_path_);
+        if (fd < 0) {
+            std::perror("cannot create the input file");
+            std::exit(1);
+        }
+        ::close(fd);
+
+        std::ofstream out{ m_path_ };
+        for (long long i = 0; i < lineCount; ++i) {
+            out << "T " << i << " 1/4 08/15/" << i % 100 << " Govt Corp\n";
+        }
+    }
+
+    ~TempFile()
+    {
+        ::unlink(m_path_);
+    }
+};
+
+void readGetline(const char *path, std::pmr::memory_resource *resource)
+{
+    std::ifstream                      in{ path };
+    std::pmr::vector<std::pmr::string> lines{ resource };
+    std::pmr::string                   line{ resource };
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    do_not_optimize(lines);
+}
+
+void readViews(const char *path, std::pmr::memory_resource *resource)
+{
+    pstring_line_reader       reader{ path };
+    std::pmr::vector<pstring> lines{ resource };
+    pstring                   line{ "", resource };
+    while (reader.next(line)) {
+        lines.push_back(line);
+    }
+    do_not_optimize(lines);
+}
+
+void readBatches(const char *path, std::pmr::memory_resource *resource)
+{
+    std::pmr::monotonic_buffer_resource arena{ resource };
+    pstring_line_reader                 reader{ path };
+    std::pmr::vector<pstring>           lines{ resource };
+    while (reader.next_batch(lines, batchSize, &arena)) {
+    }
+    do_not_optimize(lines);
+}
+
+template <class FUNCTION>
+void benchmark(const char *name, FUNCTION function, const char *path)
+{
+    Stopwatch stopwatch;
+    function(path, std::pmr::new_delete_resource());
+    report(name, stopwatch.elapsed_ns(), lineCount);
+}
+
+template <class FUNCTION>
+void measure(const char *name, FUNCTION function, const char *path)
+{
+    std::pmr::test_resource tpmr{ name };
+    function(path, &tpmr);
+    std::printf("%-40s %10lld allocations %10lld peak bytes\n",
+                name, tpmr.total_blocks(), tpmr.max_bytes());
+}
+
+int main()
+{
+    TempFile file;
+
+    benchmark("getline into pmr::string", readGetline, file.m_path_);
+    benchmark("mapped, pstring views", readViews, file.m_path_);
+    benchmark("mapped, batches into an arena", readBatches, file.m_path_);
+
+    measure("getline into pmr::string", readGetline, file.m_path_);
+    measure("mapped, pstring views", readViews, file.m_path_);
+    measure("mapped, batches into an arena", readBatches, file.m_path_);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,158 @@
+// Compare building and freeing linked lists node by node through
+// 'polymorphic_allocator_P0339R5::new_object', which calls the resource for
+// every node, with an 'object_pool', which calls it once per chunk.
+
+#include <memory_resource_p1160>
+#include <cstddef>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <object_pool.h>
+
+#include <supportlib/stopwatch.h>
+
+struct Node {
+    Node *m_next_;
+    long  m_value_;
+
+    explicit Node(long value, Node *next)
+    : m_next_(next)
+    , m_value_(value)
+    {
+    }
+};
+
+constexpr long long iterations  = 10000000;
+constexpr long      listLength  = 1000;
+constexpr int       threadCount = 4;
+
+template <class ALLOCATOR>
+void buildLists(ALLOCATOR& alloc, long long iterations)
+{
+    for (long long done = 0; done < iterations; done += listLength) {
+        Node *head = nullptr;
+        for (long i = 0; i < listLength; ++i) {
+            head = alloc.template new_object<Node>(i, head);
+        }
+        do_not_optimize(head);
+        while (head) {
+            Node *next = head->m_next_;
+            alloc.delete_object(head);
+            head = next;
+        }
+    }
+}
+
+template <class FUNCTION>
+void benchmark(const char *name, FUNCTION function, long long iterations)
+{
+    Stopwatch stopwatch;
+    function(iterations);
+    report(name, stopwatch.elapsed_ns(), iterations);
+}
+
+template <class POOL>
+void buildInThreads(POOL& pool, long long iterations)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&pool, iterations]() {
+            buildLists(pool, iterations / threadCount);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+struct PoolAllocator {
+    // Present an 'object_pool' with the interface used by 'buildLists'.
+
+    object_pool<Node>& m_pool_;
+
+    template <class T, class... ArgTypes>
+    T *new_object(ArgTypes&&... args)
+    {
+        return m_pool_.new_object(std::forward<ArgTypes>(args)...);
+    }
+
+    void delete_object(Node *node)
+    {
+        m_pool_.delete_object(node);
+    }
+};
+
+int main()
+{
+    std::pmr::unsynchronized_pool_resource unsync;
+    std::pmr::synchronized_pool_resource   sync;
+
+    benchmark("new_object, new_delete_resource", [](long long n) {
+        std::pmr::polymorphic_allocator_P0339R5<> alloc{
+                                            std::pmr::new_delete_resource() };
+        buildLists(alloc, n);
+    }, iterations);
+
+    benchmark("new_object, unsynchronized_pool_resource", [&](long long n) {
+        std::pmr::polymorphic_allocator_P0339R5<> alloc{ &unsync };
+        buildLists(alloc, n);
+    }, iterations);
+
+    benchmark("object_pool", [](long long n) {
+        object_pool<Node> pool;
+        PoolAllocator     alloc{ pool };
+        buildLists(alloc, n);
+    }, iterations);
+
+    benchmark("4 threads, new_object, synchronized_pool_resource",
+              [&](long long n) {
+        std::pmr::polymorphic_allocator_P0339R5<> alloc{ &sync };
+        buildInThreads(alloc, n);
+    }, iterations);
+
+    benchmark("4 threads, synchronized object_pool", [](long long n) {
+        object_pool_options options;
+        options.synchronized = true;
+
+        object_pool<Node> pool{ options };
+        PoolAllocator     alloc{ pool };
+        buildInThreads(alloc, n);
+    }, iterations);
+
+    benchmark("4 threads, object_pool with thread cache", [](long long n) {
+        object_pool_options options;
+        options.synchronized = true;
+        options.thread_cache = 256;
+
+        object_pool<Node> pool{ options };
+        PoolAllocator     alloc{ pool };
+        buildInThreads(alloc, n);
+    }, iterations);
+
+    std::pmr::test_resource tpmr{ "object_pool" };
+    {
+        object_pool<Node> pool{ &tpmr };
+        PoolAllocator     alloc{ pool };
+        buildLists(alloc, iterations / 10);
+    }
+    std::printf("%-40s %10lld allocations for %lld nodes\n",
+                "object_pool", tpmr.total_blocks(), iterations / 10);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,98 @@
+// Compare keeping one 'pstring' per occurrence with interning the occurrences
+// in a 'pstring_pool', for data that repeats a few symbols many times.
+
+#include <memory_resource_p1160>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <pstring_pool.h>
+
+#include <supportlib/stopwatch.h>
+
+constexpr int       symbolCount = 500;
+constexpr long long occurrences = 200000;
+
+std::vector<std::string> makeSymbols()
+{
+    std::vector<std::string> symbols;
+    char                     name[64];
+    for (int i = 0; i < symbolCount; ++i) {
+        std::snprintf(name, sizeof name,
+                      "T %d 1/4 08/15/%02d Govt Corp", i, i % 100);
+        symbols.emplace_back(name);
+    }
+    return symbols;
+}
+
+void perOccurrence(const std::vector<std::string>& symbols,
+                   std::pmr::memory_resource       *resource)
+{
+    std::pmr::vector<pstring> strings{ resource };
+    strings.reserve(occurrences);
+    for (long long i = 0; i < occurrences; ++i) {
+        strings.emplace_back(std::string_view{ symbols[i * 7 % symbolCount] });
+    }
+    do_not_optimize(strings);
+}
+
+void interned(const std::vector<std::string>& symbols,
+              std::pmr::memory_resource       *resource)
+{
+    pstring_pool                            pool{ resource };
+    std::pmr::vector<pstring_pool::handle> handles{ resource };
+    handles.reserve(occurrences);
+    for (long long i = 0; i < occurrences; ++i) {
+        handles.push_back(pool.intern(symbols[i * 7 % symbolCount]));
+    }
+    do_not_optimize(handles);
+}
+
+template <class FUNCTION>
+void benchmark(const char                      *name,
+               FUNCTION                         function,
+               const std::vector<std::string>&  symbols)
+{
+    Stopwatch stopwatch;
+    function(symbols, std::pmr::new_delete_resource());
+    report(name, stopwatch.elapsed_ns(), occurrences);
+}
+
+template <class FUNCTION>
+void measure(const char                      *name,
+             FUNCTION                         function,
+             const std::vector<std::string>&  symbols)
+{
+    std::pmr::test_resource tpmr{ name };
+    function(symbols, &tpmr);
+    std::printf("%-40s %10lld allocations %10lld peak bytes\n",
+                name, tpmr.total_blocks(), tpmr.max_bytes());
+}
+
+int main()
+{
+    const std::vector<std::string> symbols = makeSymbols();
+
+    benchmark("pstring per occurrence", perOccurrence, symbols);
+    benchmark("interned in a pstring_pool", interned, symbols);
+
+    measure("pstring per occurrence", perOccurrence, symbols);
+    measure("interned in a pstring_pool", interned, symbols);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,70 @@
+// Compare the small buffer 'pstring' with the stage 9 layout, which allocates
+// every string, on short keys.
+
+#include <memory_resource_p1160>
+
+#include <pstring_last.h>
+#include <pstring_stage9.h>
+
+#include <supportlib/stopwatch.h>
+
+#include <cstdio>
+
+static const char *const keys[] = {
+    "abc12", "IBM", "MSFT US Equity", "T 2 1/4 08/15/27", "EURUSD Curncy",
+    "SPX Index", "GOOGL", "barfool"
+};
+
+constexpr long long iterations = 1000000;
+
+template <class STRING>
+void benchmark(const char *name)
+{
+    std::pmr::memory_resource *pmrp = std::pmr::new_delete_resource();
+
+    Stopwatch stopwatch;
+    for (long long i = 0; i < iterations; ++i) {
+        STRING key{ keys[i % 8], pmrp };
+        STRING copy{ key, pmrp };
+        do_not_optimize(copy);
+    }
+    report(name, stopwatch.elapsed_ns(), iterations);
+}
+
+template <class STRING>
+void count_allocations(const char *name)
+{
+    std::pmr::test_resource tpmr{ name };
+
+    for (const char *key : keys) {
+        STRING s{ key, &tpmr };
+        STRING copy{ s, &tpmr };
+    }
+    std::printf("%-40s %10lld allocations for %zu keys\n",
+                name, tpmr.total_blocks(), 2 * (sizeof keys / sizeof *keys));
+}
+
+int main()
+{
+    benchmark<stage9::pstring>("stage 9 construct + copy");
+    benchmark<pstring>        ("small buffer construct + copy");
+
+    count_allocations<stage9::pstring>("stage 9");
+    count_allocations<pstring>        ("small buffer");
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,153 @@
+// Compare a 'std::pmr::vector' of 'pstring' with a columnar 'pstring_vector'
+// when building, scanning, and sorting many strings.
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <pstring_last.h>
+#include <pstring_vector.h>
+
+#include <supportlib/stopwatch.h>
+
+constexpr long long stringCount = 500000;
+
+std::vector<std::string> makeStrings()
+{
+    std::vector<std::string> strings;
+    char                     name[64];
+    for (long long i = 0; i < stringCount; ++i) {
+        std::snprintf(name, sizeof name, "T %lld 1/4 08/15/%02lld Govt Corp",
+                      i * 7919 % stringCount, i % 100);
+        strings.emplace_back(name);
+    }
+    return strings;
+}
+
+struct VectorOfPstring {
+    std::pmr::vector<pstring> m_strings_;
+
+    explicit VectorOfPstring(std::pmr::memory_resource *resource)
+    : m_strings_(resource)
+    {
+    }
+
+    void build(const std::vector<std::string>& strings)
+    {
+        for (const std::string& s : strings) {
+            m_strings_.emplace_back(std::string_view{ s });
+        }
+    }
+
+    size_t scan() const
+    {
+        size_t sum = 0;
+        for (const pstring& s : m_strings_) {
+            sum += s.size() + std::string_view(s).back();
+        }
+        return sum;
+    }
+
+    void sort()
+    {
+        std::sort(m_strings_.begin(), m_strings_.end());
+    }
+};
+
+struct ColumnarVector {
+    pstring_vector m_strings_;
+
+    explicit ColumnarVector(std::pmr::memory_resource *resource)
+    : m_strings_(resource)
+    {
+    }
+
+    void build(const std::vector<std::string>& strings)
+    {
+        for (const std::string& s : strings) {
+            m_strings_.push_back(s);
+        }
+    }
+
+    size_t scan() const
+    {
+        size_t sum = 0;
+        for (std::string_view s : m_strings_) {
+            sum += s.size() + s.back();
+        }
+        return sum;
+    }
+
+    void sort()
+    {
+        m_strings_.sort();
+    }
+};
+
+template <class CONTAINER>
+void benchmark(const char *name, const std::vector<std::string>& strings)
+{
+    CONTAINER container{ std::pmr::new_delete_resource() };
+    char      label[64];
+
+    Stopwatch stopwatch;
+    container.build(strings);
+    std::snprintf(label, sizeof label, "%s build", name);
+    report(label, stopwatch.elapsed_ns(), stringCount);
+
+    stopwatch.restart();
+    size_t sum = 0;
+    for (int i = 0; i < 10; ++i) {
+        sum += container.scan();
+    }
+    do_not_optimize(sum);
+    std::snprintf(label, sizeof label, "%s scan", name);
+    report(label, stopwatch.elapsed_ns(), 10 * stringCount);
+
+    stopwatch.restart();
+    container.sort();
+    std::snprintf(label, sizeof label, "%s sort", name);
+    report(label, stopwatch.elapsed_ns(), stringCount);
+}
+
+template <class CONTAINER>
+void measure(const char *name, const std::vector<std::string>& strings)
+{
+    std::pmr::test_resource tpmr{ name };
+    {
+        CONTAINER container{ &tpmr };
+        container.build(strings);
+    }
+    std::printf("%-40s %10lld allocations %10lld peak bytes\n",
+                name, tpmr.total_blocks(), tpmr.max_bytes());
+}
+
+int main()
+{
+    const std::vector<std::string> strings = makeStrings();
+
+    benchmark<VectorOfPstring>("vector<pstring>", strings);
+    benchmark<ColumnarVector> ("pstring_vector", strings);
+
+    measure<VectorOfPstring>("vector<pstring>", strings);
+    measure<ColumnarVector> ("pstring_vector", strings);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,132 @@
+// Compare allocating small objects through 'polymorphic_allocator_P0339R5',
+// which calls the resource through virtual functions, with
+// 'static_resource_allocator', which calls the concrete resource directly.
+
+#include <memory_resource_p1160>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+
+#include <supportlib/stopwatch.h>
+
+class churn_resource final : public std::pmr::memory_resource {
+    // A free list of fixed size blocks carved from a single buffer: about
+    // the cheapest resource there is, so the cost of the call shows.
+
+    template <class, class>
+        friend class std::pmr::static_resource_allocator;
+
+    static constexpr size_t block_size  = 64;
+    static constexpr size_t block_count = 1024;
+
+    union block {
+        block *m_next_;
+        alignas(std::max_align_t) char m_bytes_[block_size];
+    };
+
+    block  m_blocks_[block_count];
+    block *m_free_{ nullptr };
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (bytes > block_size || alignment > alignof(std::max_align_t) ||
+            !m_free_) {
+            throw std::bad_alloc();
+        }
+        block *result = m_free_;
+        m_free_ = result->m_next_;
+        return result;
+    }
+
+    void do_deallocate(void *p, size_t, size_t) override
+    {
+        block *freed = static_cast<block *>(p);
+        freed->m_next_ = m_free_;
+        m_free_ = freed;
+    }
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+
+public:
+    churn_resource()
+    {
+        for (block& b : m_blocks_) {
+            b.m_next_ = m_free_;
+            m_free_ = &b;
+        }
+    }
+};
+
+struct Node {
+    Node *m_next_;
+    long  m_value_;
+};
+
+constexpr long long iterations = 10000000;
+constexpr int       liveNodes  = 64;
+
+template <class ALLOCATOR>
+void churn(ALLOCATOR alloc, long long iterations)
+{
+    // Keep a ring of live nodes, replacing the oldest one at each step.
+
+    Node *ring[liveNodes] = {};
+    for (long long i = 0; i < iterations; ++i) {
+        Node *&slot = ring[i % liveNodes];
+        if (slot) {
+            alloc.deallocate_object(slot);
+        }
+        slot = alloc.template allocate_object<Node>();
+        slot->m_value_ = i;
+        do_not_optimize(slot);
+    }
+    for (Node *node : ring) {
+        if (node) {
+            alloc.deallocate_object(node);
+        }
+    }
+}
+
+template <class RESOURCE>
+void benchmark(const char *name, RESOURCE *resource, long long iterations)
+{
+    char label[64];
+
+    Stopwatch stopwatch;
+    churn(std::pmr::polymorphic_allocator_P0339R5<>(resource), iterations);
+    std::snprintf(label, sizeof label, "%s, virtual", name);
+    report(label, stopwatch.elapsed_ns(), iterations);
+
+    stopwatch.restart();
+    churn(std::pmr::static_resource_allocator<RESOURCE>(resource), iterations);
+    std::snprintf(label, sizeof label, "%s, direct", name);
+    report(label, stopwatch.elapsed_ns(), iterations);
+}
+
+int main()
+{
+    static churn_resource fixed;
+    benchmark("free list", &fixed, iterations);
+
+    std::pmr::test_resource tpmr{ "churn" };
+    benchmark("test_resource", &tpmr, iterations / 10);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
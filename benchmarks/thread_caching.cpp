@@ -0,0 +1,89 @@
+// Compare threads allocating and freeing small blocks through a shared
+// 'synchronized_pool_resource' or 'test_resource', which take a lock on
+// every call, with the same resources behind a 'thread_caching_resource',
+// which serves most calls from a cache of the calling thread.
+
+#include <memory_resource_p1160>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <thread_caching_resource.h>
+
+#include <supportlib/stopwatch.h>
+
+constexpr long long iterations = 4000000;
+constexpr int       liveBlocks = 16;
+
+void churn(std::pmr::memory_resource *resource, long long iterations)
+{
+    void *blocks[liveBlocks] = {};
+    for (long long i = 0; i < iterations; ++i) {
+        void *&slot = blocks[i % liveBlocks];
+        if (slot) {
+            resource->deallocate(slot, 64, 8);
+        }
+        slot = resource->allocate(64, 8);
+        do_not_optimize(slot);
+    }
+    for (void *block : blocks) {
+        if (block) {
+            resource->deallocate(block, 64, 8);
+        }
+    }
+}
+
+void benchmark(const char                *name,
+               std::pmr::memory_resource *resource,
+               int                        threadCount)
+{
+    Stopwatch stopwatch;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back(churn, resource, iterations / threadCount);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    char label[80];
+    std::snprintf(label, sizeof label, "%d threads, %s", threadCount, name);
+    report(label, stopwatch.elapsed_ns(), iterations);
+}
+
+int main()
+{
+    for (int threadCount : { 1, 4 }) {
+        std::pmr::synchronized_pool_resource pool;
+        benchmark("synchronized pool", &pool, threadCount);
+
+        thread_caching_resource cachedPool{ &pool };
+        benchmark("cached synchronized pool", &cachedPool, threadCount);
+
+        std::pmr::test_resource tr{ "shared" };
+        benchmark("test_resource", &tr, threadCount);
+
+        thread_caching_resource cachedTest{ &tr };
+        benchmark("cached test_resource", &cachedTest, threadCount);
+
+        std::printf("%-40s %10.4f hit rate\n",
+                    "cached test_resource", cachedTest.stats().hit_rate());
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
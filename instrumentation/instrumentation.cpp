@@ -0,0 +1,296 @@
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+int errorCount{ 0 };
+
+void thread_attribution_test(bool verbose)
+{
+    Framer framer{ "Per-thread attribution", verbose };
+
+    std::pmr::test_resource tpmr{ "pipeline", verbose };
+
+    constexpr int numBlocks = 4;
+
+    std::vector<void *> handoff;
+
+    std::thread producer{ [&]() {
+        for (int i = 0; i < numBlocks; ++i) {
+            handoff.push_back(tpmr.allocate(64));
+        }
+    } };
+    producer.join();
+
+    void *own = tpmr.allocate(16);
+
+    // The consumer frees what the producer allocated.
+
+    for (void *p : handoff) {
+        tpmr.deallocate(p, 64);
+    }
+
+    ASSERT_EQ(tpmr.thread_count(), 2);
+    ASSERT_EQ(tpmr.cross_thread_deallocations(), numBlocks);
+
+    std::pmr::test_resource_thread_usage producerUsage = tpmr.thread_usage(0);
+    ASSERT_EQ(producerUsage.usage.total_blocks, numBlocks);
+    ASSERT_EQ(producerUsage.usage.max_bytes, numBlocks * 64);
+    ASSERT_EQ(producerUsage.usage.bytes_in_use, 0);
+    ASSERT_EQ(producerUsage.cross_thread_deallocations, numBlocks);
+
+    std::pmr::test_resource_thread_usage consumerUsage =
+                                                      tpmr.this_thread_usage();
+    ASSERT_EQ(consumerUsage.usage.bytes_in_use, 16);
+    ASSERT_EQ(consumerUsage.cross_thread_deallocations, 0);
+
+    tpmr.deallocate(own, 16);
+
+    // A thread started after another one exited has its own record, even
+    // if it reuses the same 'std::thread::id'.
+
+    std::pmr::test_resource relay{ "relay", verbose };
+
+    void *left = nullptr;
+    std::thread first{ [&]() { left = relay.allocate(32); } };
+    first.join();
+    std::thread second{ [&]() { relay.deallocate(left, 32); } };
+    second.join();
+
+    ASSERT_EQ(relay.thread_count(), 1);
+    ASSERT_EQ(relay.cross_thread_deallocations(), 1);
+    ASSERT_EQ(relay.thread_usage(0).cross_thread_deallocations, 1);
+}
+
+void phase_tag_test(bool verbose)
+{
+    Framer framer{ "Phase tags", verbose };
+
+    std::pmr::test_resource tpmr{ "request", verbose };
+
+    void *untagged = tpmr.allocate(8);
+    void *parsed;
+    void *index;
+    {
+        std::pmr::test_resource_tag_scope parse{ "parse" };
+        parsed = tpmr.allocate(32);
+        {
+            std::pmr::test_resource_tag_scope build{ "build-index" };
+            index = tpmr.allocate(128);
+        }
+        void *scratch = tpmr.allocate(64);
+        tpmr.deallocate(scratch, 64);
+    }
+
+    ASSERT_EQ(tpmr.tag_usage("parse").bytes_in_use, 32);
+    ASSERT_EQ(tpmr.tag_usage("parse").max_bytes, 96);
+    ASSERT_EQ(tpmr.tag_usage("parse").total_bytes, 96);
+    ASSERT_EQ(tpmr.tag_usage("build-index").bytes_in_use, 128);
+    ASSERT_EQ(tpmr.tag_usage(0u).bytes_in_use, 8);
+    ASSERT_EQ(std::pmr::test_resource_current_tag(), 0u);
+
+    if (verbose) {
+        tpmr.print();
+    }
+
+    tpmr.deallocate(index, 128);
+    tpmr.deallocate(parsed, 32);
+    tpmr.deallocate(untagged, 8);
+}
+
+void peak_snapshot_test(bool verbose)
+{
+    Framer framer{ "Peak snapshot", verbose };
+
+    std::pmr::test_resource tpmr{ "batch", verbose };
+    tpmr.set_track_peak(true);
+    tpmr.set_capture_stacks(true);
+
+    void *early = tpmr.allocate(100);
+    void *big;
+    {
+        std::pmr::test_resource_tag_scope load{ "load" };
+        void *small = tpmr.allocate(10);
+        big = tpmr.allocate(1000);
+        tpmr.deallocate(small, 10);
+    }
+    tpmr.deallocate(early, 100);
+
+    void *late = tpmr.allocate(50);  // below the peak, not in the snapshot
+
+    std::pmr::test_resource_block blocks[4];
+    ASSERT_EQ(tpmr.peak_blocks(blocks, 4), 3);
+    ASSERT_EQ(tpmr.peak_bytes(), 1110);
+    ASSERT_EQ(blocks[0].index, 0);
+    ASSERT_EQ(blocks[2].bytes, 1000u);
+    ASSERT_EQ(blocks[2].tag, std::pmr::test_resource_tag_id("load"));
+
+    if (verbose) {
+        tpmr.print_peak();
+    }
+
+    tpmr.deallocate(late, 50);
+
+    void *bigger = tpmr.allocate(2000);  // new peak: 'big' and 'bigger'
+    ASSERT_EQ(tpmr.peak_blocks(), 2);
+    ASSERT_EQ(tpmr.peak_bytes(), 3000);
+
+    tpmr.deallocate(bigger, 2000);
+    tpmr.deallocate(big, 1000);
+}
+
+void timeline_test(bool verbose)
+{
+    Framer framer{ "Usage timeline", verbose };
+
+    std::pmr::test_resource tpmr{ "sawtooth" };
+    tpmr.set_timeline(8);
+
+    // Grow a buffer and release it in bulk a few times: a sawtooth.
+
+    for (int round = 0; round < 4; ++round) {
+        void *blocks[16];
+        for (void *& block : blocks) {
+            block = tpmr.allocate(32);
+        }
+        for (void *block : blocks) {
+            tpmr.deallocate(block, 32);
+        }
+    }
+
+    // 128 events were recorded in at most 8 samples.
+
+    ASSERT((tpmr.timeline_size() <= 8));
+    ASSERT((tpmr.timeline_size() >= 4));
+
+    if (verbose) {
+        tpmr.print_timeline_csv();
+    }
+
+    // The smallest series holds two samples; merging keeps the later one,
+    // with the higher peak of the pair.
+
+    for (size_t capacity : { 1, 2 }) {
+        std::pmr::test_resource small{ "spike" };
+        small.set_timeline(capacity);
+
+        void *spike = small.allocate(100);
+        small.deallocate(spike, 100);
+        void *blip = small.allocate(10);
+        small.deallocate(blip, 10);
+
+        ASSERT_EQ(small.timeline_size(), 2u);
+
+        FILE *csv = std::tmpfile();
+        ASSERT(csv);
+        if (!csv) {
+            continue;                                               // CONTINUE
+        }
+        small.print_timeline_csv(csv);
+        std::rewind(csv);
+
+        long long event[2], allocations[2], ns, bytes[2], blocks, peak[2];
+        int       rows = 0;
+        char      line[128];
+        while (std::fgets(line, sizeof line, csv)) {
+            if (rows < 2 && 6 == std::sscanf(line,
+                                             "%lld,%lld,%lld,%lld,%lld,%lld",
+                                             &event[rows],
+                                             &allocations[rows],
+                                             &ns,
+                                             &bytes[rows],
+                                             &blocks,
+                                             &peak[rows])) {
+                ++rows;
+            }
+        }
+        std::fclose(csv);
+
+        ASSERT_EQ(rows, 2);
+        if (2 != rows) {
+            continue;                                               // CONTINUE
+        }
+        ASSERT_EQ(event[0], 2);
+        ASSERT_EQ(allocations[0], 1);
+        ASSERT_EQ(bytes[0], 0);
+        ASSERT_EQ(peak[0], 100);
+        ASSERT_EQ(event[1], 4);
+        ASSERT_EQ(allocations[1], 2);
+        ASSERT_EQ(bytes[1], 0);
+        ASSERT_EQ(peak[1], 10);
+    }
+}
+
+void growth_test(bool verbose)
+{
+    Framer framer{ "Growth reallocations", verbose };
+
+    std::pmr::test_resource tpmr{ "growth", verbose };
+    tpmr.set_track_growth(true);
+
+    {
+        std::pmr::test_resource_tag_scope unreserved{ "unreserved" };
+
+        std::pmr::vector<int> values{ &tpmr };
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(i);
+        }
+    }
+    {
+        std::pmr::test_resource_tag_scope reserved{ "reserved" };
+
+        std::pmr::vector<int> values{ &tpmr };
+        values.reserve(100);
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(i);
+        }
+    }
+
+    std::pmr::test_resource_growth_site sites[2];
+    ASSERT_EQ(tpmr.growth_sites(sites, 2), 1);
+    ASSERT_EQ(sites[0].tag, std::pmr::test_resource_tag_id("unreserved"));
+    ASSERT((sites[0].reallocations > 0));
+    ASSERT_EQ(sites[0].reallocations, tpmr.growth_reallocations());
+    ASSERT_EQ(sites[0].longest_chain, sites[0].reallocations);
+    ASSERT_EQ(tpmr.growth_bytes_copied(), sites[0].bytes_copied);
+}
+
+void tests(bool verbose)
+{
+    thread_attribution_test(verbose);
+    phase_tag_test         (verbose);
+    peak_snapshot_test     (verbose);
+    timeline_test          (verbose);
+    growth_test            (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
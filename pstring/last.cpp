@@ -8,13 +8,30 @@
 
 #include <memory_resource_p1160>
 
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 void breathing_test  (bool verbose);
 void copy_test       (bool verbose);
 void assign_test     (bool verbose);
 void self_assign_test(bool verbose);
 void move_test       (bool verbose);
+void small_test      (bool verbose);
+void length_test     (bool verbose);
+void reuse_test      (bool verbose);
+void move_assign_test(bool verbose);
+void swap_test       (bool verbose);
+void append_test     (bool verbose);
+void concat_test     (bool verbose);
+void compare_test    (bool verbose);
+void lookup_test     (bool verbose);
+void static_test     (bool verbose);
+void shared_test     (bool verbose);
+void substr_test     (bool verbose);
 
 int errorCount{ 0 };
 
@@ -25,6 +42,18 @@ void tests(bool verbose)
     assign_test     (verbose);
     self_assign_test(verbose);
     move_test       (verbose);
+    small_test      (verbose);
+    length_test     (verbose);
+    reuse_test      (verbose);
+    move_assign_test(verbose);
+    swap_test       (verbose);
+    append_test     (verbose);
+    concat_test     (verbose);
+    compare_test    (verbose);
+    lookup_test     (verbose);
+    static_test     (verbose);
+    shared_test     (verbose);
+    substr_test     (verbose);
 }
 
 int main()
@@ -106,7 +135,7 @@ void move_test(bool verbose)
     std::pmr::test_resource_monitor trm{ tr };
     tr.set_verbose(verbose);
 
-    pstring astring{ "barfool", &tr };
+    pstring astring{ "barfool, but too long for the small buffer", &tr };
     ASSERT(trm.is_total_up());
     ASSERT_EQ(trm.delta_blocks_in_use(), 1);
     trm.reset();
@@ -115,6 +144,586 @@ void move_test(bool verbose)
 
     ASSERT(drm.is_in_use_same()); // Did not allocate`bstring` with this
     ASSERT(drm.is_total_same());  // Did not allocate /anything/ with this
+    ASSERT(trm.is_total_same());  // Took over the buffer
+}
+
+void small_test(bool verbose)
+{
+    Framer framer{ "small string", verbose };
+
+    std::pmr::test_resource           dr{ "default" };
+    std::pmr::test_resource_monitor  drm{ dr };
+    std::pmr::default_resource_guard drg{ &dr };
+    dr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr2{ "other" };
+    std::pmr::test_resource_monitor trm2{ tr2 };
+    tr2.set_verbose(verbose);
+
+    pstring astring{ "abc12", &tr };
+    pstring longest{ "exactly 23 characters.." , &tr };
+    ASSERT_EQ(longest.size(), pstring::small_capacity);
+
+    pstring copied{ astring, &tr };
+    pstring copied2{ astring, &tr2 };
+    pstring moved{ std::move(copied) };
+    pstring moved2{ std::move(copied2), &tr };
+
+    pstring assigned{ "", &tr2 };
+    assigned = longest;
+
+    ASSERT_EQ(moved.str(), "abc12");
+    ASSERT_EQ(moved2.str(), "abc12");
+    ASSERT_EQ(assigned.str(), "exactly 23 characters..");
+
+    ASSERT(trm.is_total_same());
+    ASSERT(trm2.is_total_same());
+    ASSERT(drm.is_total_same());
+
+    // Outgrowing the small buffer allocates from the right resource.
+
+    pstring grown{ "abc", &tr2 };
+    grown = pstring{ "twenty-four characters.." , &tr };
+    ASSERT_EQ(trm.delta_total_blocks(), 1);
+    ASSERT_EQ(trm2.delta_total_blocks(), 1);
+    ASSERT_EQ(grown.get_allocator().resource(), &tr2);
+
+    // Moving a long string to another resource copies it exactly once.
+
+    trm2.reset();
+    pstring moved3{ std::move(grown), &tr };
+    ASSERT_EQ(moved3.str(), "twenty-four characters..");
+    ASSERT(trm2.is_total_same());
+    ASSERT_EQ(trm.delta_total_blocks(), 2);
+}
+
+static const char *const shortText = "abc12";
+static const char *const longText  = "barfool, but too long for the small buffer";
+static const char *const longText2 = "another string too long for the small one";
+
+void move_assign_test(bool verbose)
+{
+    Framer framer{ "move assignment", verbose };
+
+    std::pmr::test_resource tpmr{ "tester", verbose };
+    std::pmr::test_resource other{ "other", verbose };
+
+    // Every combination of short and long values, and of equal and unequal
+    // allocators, with every allocation failing in turn.
+
+    for (const char *srcText : { shortText, longText }) {
+        for (const char *dstText : { shortText, longText2 }) {
+            for (bool isSame : { true, false }) {
+                std::pmr::exception_test_loop(tpmr,
+                                       [&](std::pmr::memory_resource& pmr) {
+                    std::pmr::memory_resource *dstPmr = isSame ? &pmr
+                                                               : &other;
+                    pstring src{ srcText, &pmr };
+                    pstring dst{ dstText, dstPmr };
+
+                    dst = std::move(src);
+
+                    ASSERT_EQ(dst.str(), srcText);
+                    ASSERT_EQ(dst.get_allocator().resource(), dstPmr);
+                });
+            }
+        }
+    }
+
+    // Equal allocators: the buffer changes hands, nothing is allocated.
+
+    std::pmr::test_resource_monitor trm{ tpmr };
+    {
+        pstring src{ longText, &tpmr };
+        pstring dst{ longText2, &tpmr };
+        trm.reset();
+
+        dst = std::move(src);
+        ASSERT(trm.is_total_same());
+        ASSERT_EQ(trm.delta_blocks_in_use(), -1);
+        ASSERT_EQ(src.size(), 0u);
+    }
+
+    // Unequal allocators: exactly one allocation, from the target.
+
+    std::pmr::test_resource_monitor orm{ other };
+    {
+        pstring src{ longText, &tpmr };
+        pstring dst{ shortText, &other };
+        trm.reset();
+        orm.reset();
+
+        dst = std::move(src);
+        ASSERT(trm.is_total_same());
+        ASSERT_EQ(orm.delta_total_blocks(), 1);
+        ASSERT_EQ(dst.str(), longText);
+    }
+}
+
+void swap_test(bool verbose)
+{
+    Framer framer{ "swap", verbose };
+
+    std::pmr::test_resource tpmr{ "tester", verbose };
+    std::pmr::test_resource other{ "other", verbose };
+
+    for (const char *aText : { shortText, longText }) {
+        for (const char *bText : { shortText, longText2 }) {
+            for (bool isSame : { true, false }) {
+                std::pmr::exception_test_loop(tpmr,
+                                       [&](std::pmr::memory_resource& pmr) {
+                    std::pmr::memory_resource *bPmr = isSame ? &pmr
+                                                             : &other;
+                    pstring a{ aText, &pmr };
+                    pstring b{ bText, bPmr };
+
+                    swap(a, b);
+
+                    ASSERT_EQ(a.str(), bText);
+                    ASSERT_EQ(b.str(), aText);
+                    ASSERT_EQ(a.get_allocator().resource(), &pmr);
+                    ASSERT_EQ(b.get_allocator().resource(), bPmr);
+                });
+            }
+        }
+    }
+
+    std::pmr::test_resource_monitor trm{ tpmr };
+    {
+        pstring a{ longText, &tpmr };
+        pstring b{ longText2, &tpmr };
+        trm.reset();
+
+        a.swap(b);
+        ASSERT(trm.is_total_same());
+        ASSERT_EQ(a.str(), longText2);
+    }
+}
+
+void append_test(bool verbose)
+{
+    Framer framer{ "append", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    // Geometric growth: 1000 appends, a handful of allocations.
+
+    {
+        pstring built{ "", &tr };
+        for (int i = 0; i < 1000; ++i) {
+            built += 'x';
+        }
+        ASSERT_EQ(built.size(), 1000u);
+        ASSERT_EQ(built.str(), std::string(1000, 'x'));
+        ASSERT_EQ(trm.delta_total_blocks(), 6);  // 47, 95, ..., 1535
+    }
+
+    // Reserving first: exactly one allocation.
+
+    trm.reset();
+    {
+        pstring built{ "", &tr };
+        built.reserve(1000);
+
+        // 'test_resource' rounds the 1001 bytes up to 1008, and the string
+        // uses the slack.
+
+        ASSERT_EQ(built.capacity(), 1007u);
+        for (int i = 0; i < 100; ++i) {
+            built.append("0123456789", 10);
+        }
+        ASSERT_EQ(built.size(), 1000u);
+        ASSERT_EQ(trm.delta_total_blocks(), 1);
+    }
+
+    // Appending to itself, in place and while growing.
+
+    {
+        pstring doubled{ "abc12", &tr };
+        doubled += doubled;
+        ASSERT_EQ(doubled.str(), "abc12abc12");
+        doubled += doubled;
+        doubled += doubled;
+        ASSERT_EQ(doubled.str(), "abc12abc12abc12abc12abc12abc12abc12abc12");
+    }
+}
+
+void concat_test(bool verbose)
+{
+    Framer framer{ "concatenation", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    pstring a{ "barfool, but too long ", &tr };
+    pstring b{ "for the small ", &tr };
+    pstring c{ "buffer", &tr };
+    trm.reset();
+
+    pstring abc{ a + b + c + "!", &tr };
+    ASSERT_EQ(abc.str(), "barfool, but too long for the small buffer!");
+    ASSERT_EQ(trm.delta_total_blocks(), 1);
+
+    // Assigning into a large enough buffer allocates nothing, even when the
+    // result is made of the target's own characters.
+
+    trm.reset();
+    abc = c + "! " + b;
+    ASSERT_EQ(abc.str(), "buffer! for the small ");
+    ASSERT(trm.is_total_same());
+
+    abc = abc + abc;
+    ASSERT_EQ(abc.str(), "buffer! for the small buffer! for the small ");
+    ASSERT_EQ(trm.delta_total_blocks(), 1);
+}
+
+void compare_test(bool verbose)
+{
+    Framer framer{ "comparison", verbose };
+
+    std::pmr::test_resource tpmr{ "object", verbose };
+
+    pstring a1{ longText, &tpmr };
+    pstring a2{ longText, &tpmr };
+    pstring b{ longText2, &tpmr };
+    pstring prefix{ longText, 20, &tpmr };
+    pstring lastDiffers{ "barfool, but too long for the small bufferX", &tpmr };
+    pstring lastDiffers2{ "barfool, but too long for the small bufferY", &tpmr };
+
+    ASSERT((a1 == a2));
+    ASSERT((a1 != b));
+    ASSERT((prefix < a1));
+    ASSERT((a1 > prefix));
+    ASSERT((b < a1));           // 'a' < 'b'
+    ASSERT((a1 <= a2));
+    ASSERT((a1 >= a2));
+    ASSERT((lastDiffers != lastDiffers2));
+    ASSERT((lastDiffers < lastDiffers2));
+    ASSERT_EQ(a1.compare(longText), 0);
+
+    // Hashes are cached, and forgotten on modification.
+
+    ASSERT_EQ(a1.hash(), a2.hash());
+    ASSERT((a1 == a2));
+    a2 += "!";
+    ASSERT((a1 != a2));
+    ASSERT((a1.hash() != a2.hash()));
+    ASSERT_EQ(std::hash<pstring>()(a1), a1.hash());
+
+    // Several threads may hash the same string at once.
+
+    const pstring key{ longText2, &tpmr };
+    size_t        hashes[4];
+    std::vector<std::thread> threads;
+    for (size_t& hash : hashes) {
+        threads.emplace_back([&key, &hash]() { hash = key.hash(); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (size_t hash : hashes) {
+        ASSERT_EQ(hash, b.hash());
+    }
+}
+
+void lookup_test(bool verbose)
+{
+    Framer framer{ "hash map lookup", verbose };
+
+    std::pmr::test_resource          tr{ "map" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    std::pmr::unordered_map<pstring, int> map{ &tr };
+    map.emplace(pstring{ "IBM", &tr }, 1);
+    map.emplace(pstring{ longText, &tr }, 2);
+    map.emplace(pstring{ longText2, &tr }, 3);
+
+    pstring ibm{ "IBM", &tr };
+    pstring longKey{ longText, &tr };
+    pstring missing{ "barfool, but not in the map at all", &tr };
+    trm.reset();
+
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(map.find(ibm)->second, 1);
+        ASSERT_EQ(map.find(longKey)->second, 2);
+        ASSERT((map.find(missing) == map.end()));
+    }
+
+    ASSERT(trm.is_total_same());
+}
+
+void length_test(bool verbose)
+{
+    Framer framer{ "length-aware construction", verbose };
+
+    std::pmr::test_resource tpmr{ "object", verbose };
+
+    const char chars[] = "barfool, but too long for the small buffer";
+
+    pstring prefix{ chars, 7, &tpmr };
+    pstring viewed{ std::string_view{ chars }, &tpmr };
+    pstring embedded{ "bar\0fool", 8, &tpmr };
+
+    ASSERT_EQ(prefix.str(), "barfool");
+    ASSERT_EQ(viewed.str(), chars);
+    ASSERT_EQ(embedded.size(), 8u);
+    ASSERT_EQ(embedded.str(), std::string("bar\0fool", 8));
+    ASSERT((std::string_view{ viewed } == chars));
+}
+
+void reuse_test(bool verbose)
+{
+    Framer framer{ "assignment buffer reuse", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    pstring longest{ "the longest string of the loop below", &tr };
+    pstring shorter{ "a shorter string, still long", &tr };
+    pstring shortest{ "short", &tr };
+
+    pstring target{ "", &tr };
+    trm.reset();
+
+    target = longest;
+    ASSERT_EQ(trm.delta_total_blocks(), 1);
+
+    for (int i = 0; i < 100; ++i) {
+        target = i % 3 == 0 ? longest : i % 3 == 1 ? shorter : shortest;
+    }
+
+    ASSERT_EQ(trm.delta_total_blocks(), 1);  // Only the first one allocated
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    ASSERT_EQ(target.str(), "the longest string of the loop below");
+}
+
+void static_test(bool verbose)
+{
+    Framer framer{ "static storage", verbose };
+
+    std::pmr::test_resource           dr{ "default" };
+    std::pmr::test_resource_monitor  drm{ dr };
+    std::pmr::default_resource_guard drg{ &dr };
+    dr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr2{ "other" };
+    std::pmr::test_resource_monitor trm2{ tr2 };
+    tr2.set_verbose(verbose);
+
+    static const char literal[] = "barfool, but too long for the small buffer";
+
+    // Creating, copying, and moving refer to the literal, whatever the
+    // allocators.
+
+    {
+        pstring astring{ pstring::static_storage, literal, &tr };
+        pstring copied{ astring, &tr2 };
+        pstring moved{ std::move(copied), &tr };
+        pstring assigned{ longText2, &tr2 };
+        assigned = astring;
+
+        ASSERT(astring.is_static());
+        ASSERT_EQ(astring.size(), sizeof literal - 1);
+        ASSERT_EQ(astring.data(), literal);
+        ASSERT_EQ(moved.data(), literal);
+        ASSERT_EQ(assigned.data(), literal);
+        ASSERT((astring == assigned));
+
+        ASSERT(trm.is_total_same());
+        ASSERT_EQ(trm2.delta_total_blocks(), 1);
+        ASSERT_EQ(trm2.delta_blocks_in_use(), 0);
+    }
+    ASSERT(trm.is_total_same());
+    trm2.reset();
+
+    // The first modification copies the characters, once, with the
+    // allocator of the string; the literal is left alone.
+
+    {
+        pstring astring{ pstring::static_storage, literal, &tr };
+        pstring copied{ astring, &tr };
+
+        astring += '!';
+        ASSERT(!astring.is_static());
+        ASSERT_EQ(astring.str(), std::string(literal) + '!');
+        ASSERT_EQ(trm.delta_total_blocks(), 1);
+
+        astring += '!';
+        ASSERT_EQ(trm.delta_total_blocks(), 1);
+
+        ASSERT_EQ(copied.data(), literal);
+        ASSERT_EQ(std::string(literal),
+                  "barfool, but too long for the small buffer");
+    }
+
+    // Modifications that fit the small buffer do not allocate at all.
+
+    trm.reset();
+    {
+        pstring shorter{ pstring::static_storage, "abc12", &tr };
+        shorter += "34";
+        ASSERT(shorter.is_small());
+        ASSERT_EQ(shorter.str(), "abc1234");
+
+        pstring assigned{ pstring::static_storage, literal, &tr };
+        assigned = pstring{ "IBM", &tr };
+        ASSERT(assigned.is_small());
+        ASSERT_EQ(assigned.str(), "IBM");
+
+        pstring reassigned{ pstring::static_storage, literal, &tr };
+        reassigned = pstring{ "MSFT" } + " US Equity";
+        ASSERT_EQ(reassigned.str(), "MSFT US Equity");
+    }
+    ASSERT(trm.is_total_same());
+    ASSERT(drm.is_total_same());
+}
+
+void shared_test(bool verbose)
+{
+    Framer framer{ "shared buffer", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr2{ "other" };
+    std::pmr::test_resource_monitor trm2{ tr2 };
+    tr2.set_verbose(verbose);
+
+    {
+        pstring payload{ longText, &tr };
+        payload.make_shared();
+        ASSERT(payload.is_shared());
+        ASSERT_EQ(payload.str(), longText);
+        ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+        trm.reset();
+
+        // Copies with the same allocator share the buffer.
+
+        pstring copied{ payload, &tr };
+        pstring assigned{ longText2, &tr };
+        trm.reset();
+        assigned = copied;
+        ASSERT(copied.is_shared());
+        ASSERT_EQ(copied.data(), payload.data());
+        ASSERT_EQ(assigned.data(), payload.data());
+        ASSERT(trm.is_total_same());
+        ASSERT_EQ(trm.delta_blocks_in_use(), -1);
+        trm.reset();
+
+        // A copy with another allocator has its own characters.
+
+        pstring other{ payload, &tr2 };
+        ASSERT(!other.is_shared());
+        ASSERT_EQ(other.str(), longText);
+        ASSERT_EQ(trm2.delta_total_blocks(), 1);
+
+        // Modifying a sharing string detaches it, leaving the others alone.
+
+        copied += '!';
+        ASSERT(!copied.is_shared());
+        ASSERT_EQ(copied.str(), std::string(longText) + '!');
+        ASSERT_EQ(payload.str(), longText);
+        ASSERT_EQ(assigned.str(), longText);
+        ASSERT_EQ(trm.delta_total_blocks(), 1);
+
+        assigned = pstring{ "IBM", &tr };
+        ASSERT(assigned.is_small());
+        ASSERT_EQ(payload.str(), longText);
+    }
+
+    // The last string referring to the buffer deallocated it.
+
+    ASSERT_EQ(tr.blocks_in_use(), 0);
+    ASSERT_EQ(tr2.blocks_in_use(), 0);
+
+    // Small strings and static storage are never moved to a shared buffer.
+
+    pstring small{ shortText, &tr };
+    small.make_shared();
+    ASSERT(small.is_small());
+
+    pstring literal{ pstring::static_storage, "a literal, too long to copy" };
+    literal.make_shared();
+    ASSERT(literal.is_static());
+}
+
+void substr_test(bool verbose)
+{
+    Framer framer{ "substrings", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    // Substrings of shared and static strings refer to their characters.
+
+    {
+        pstring line{ "2019-08-15 INFO T 2 1/4 08/15/27 Govt traded", &tr };
+        line.make_shared();
+        trm.reset();
+
+        pstring date  = line.substr(0, 10);
+        pstring level = line.substr(11, 4);
+        pstring rest  = line.substr(16);
+        ASSERT(trm.is_total_same());
+
+        ASSERT_EQ(date.str(), "2019-08-15");
+        ASSERT_EQ(level.str(), "INFO");
+        ASSERT_EQ(rest.str(), "T 2 1/4 08/15/27 Govt traded");
+        ASSERT_EQ(rest.data(), line.data() + 16);
+        ASSERT((level == pstring{ "INFO" }));
+
+        pstring nested = rest.substr(2, 7);
+        ASSERT_EQ(nested.str(), "2 1/4 0");
+        ASSERT_EQ(nested.data(), line.data() + 18);
+
+        // Substrings outlive the string they were taken from.
+
+        line = pstring{ longText, &tr };
+        ASSERT_EQ(rest.str(), "T 2 1/4 08/15/27 Govt traded");
+
+        rest += " twice";
+        ASSERT_EQ(rest.str(), "T 2 1/4 08/15/27 Govt traded twice");
+        ASSERT_EQ(nested.str(), "2 1/4 0");
+    }
+    ASSERT_EQ(tr.blocks_in_use(), 0);
+
+    pstring literal{ pstring::static_storage, "SPX Index", &tr };
+    pstring index = literal.substr(4);
+    ASSERT(index.is_static());
+    ASSERT_EQ(index.str(), "Index");
+
+    // Other strings are copied.
+
+    pstring owned{ longText, &tr };
+    pstring word = owned.substr(0, 7);
+    ASSERT(word.is_small());
+    ASSERT_EQ(word.str(), "barfool");
+
+    ASSERT_EQ(owned.substr(owned.size()).size(), 0u);
+
+    bool thrown = false;
+    try {
+        owned.substr(owned.size() + 1);
+    }
+    catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
 }
 
 // ----------------------------------------------------------------------------
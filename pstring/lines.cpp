@@ -0,0 +1,221 @@
+// lines.cpp                                                          -*-C++-*-
+#include <pstring_lines.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+void read_test (bool verbose);
+void batch_test(bool verbose);
+void empty_test(bool verbose);
+void error_test(bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    read_test (verbose);
+    batch_test(verbose);
+    empty_test(verbose);
+    error_test(verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+struct TempFile {
+    // Create a temporary file with the specified contents, removed on
+    // destruction.
+
+    char m_path_[32] = "/tmp/pstring_lines_XXXXXX";
+
+    explicit TempFile(std::string_view contents)
+    {
+        const int fd = ::mkstemp(m_path_);
+        if (fd < 0 ||
+            ::write(fd, contents.data(), contents.size()) !=
+                                    static_cast<ssize_t>(contents.size())) {
+            std::perror("cannot create the test file");
+            std::exit(1);
+        }
+        ::close(fd);
+    }
+
+    ~TempFile()
+    {
+        ::unlink(m_path_);
+    }
+};
+
+void read_test(bool verbose)
+{
+    Framer framer{ "read lines", verbose };
+
+    std::pmr::test_resource           dr{ "default" };
+    std::pmr::test_resource_monitor  drm{ dr };
+    std::pmr::default_resource_guard drg{ &dr };
+    dr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    TempFile file{ "IBM\r\nMSFT US Equity\n\n"
+                   "a line much too long for the small buffer\nlast" };
+
+    pstring_line_reader reader{ file.m_path_ };
+    ASSERT_EQ(reader.size(), 67u);
+
+    pstring line{ "", &tr };
+    std::string read;
+    int count = 0;
+    while (reader.next(line)) {
+        ASSERT(line.is_static());
+        ASSERT_EQ(line.get_allocator().resource(), &tr);
+        read += line.str() + '|';
+        ++count;
+    }
+    ASSERT_EQ(count, 5);
+    ASSERT_EQ(read,
+              "IBM|MSFT US Equity||a line much too long for the small buffer|"
+              "last|");
+
+    // Reading the lines allocated nothing.
+
+    ASSERT(trm.is_total_same());
+    ASSERT(drm.is_total_same());
+
+    std::string_view view;
+    ASSERT(!reader.next(view));
+}
+
+void batch_test(bool verbose)
+{
+    Framer framer{ "batches", verbose };
+
+    std::pmr::test_resource tr{ "arena" };
+    tr.set_verbose(verbose);
+
+    std::pmr::test_resource vr{ "vector" };
+    vr.set_verbose(verbose);
+
+    std::string contents;
+    for (int i = 0; i < 1000; ++i) {
+        contents += "symbol #" + std::to_string(i) + '\n';
+    }
+    TempFile file{ contents };
+
+    std::pmr::vector<pstring> lines{ &vr };
+    {
+        std::pmr::monotonic_buffer_resource arena{ &tr };
+        {
+            pstring_line_reader reader{ file.m_path_ };
+
+            size_t batches = 0;
+            while (reader.next_batch(lines, 300, &arena)) {
+                ++batches;
+            }
+            ASSERT_EQ(batches, 4u);
+            ASSERT_EQ(lines.size(), 1000u);
+        }
+
+        // The lines outlive the reader, and are all in the arena.
+
+        ASSERT_EQ(lines[0].str(), "symbol #0");
+        ASSERT_EQ(lines[999].str(), "symbol #999");
+        ASSERT(lines[500].is_static());
+        ASSERT_EQ(lines[500].get_allocator().resource(), &vr);
+        ASSERT((tr.total_blocks() <= 4));
+
+        lines.clear();
+    }
+    ASSERT_EQ(tr.blocks_in_use(), 0);
+
+    // A batch that cannot be allocated is not lost: the reader resumes at
+    // its first line.
+
+    pstring_line_reader reader{ file.m_path_ };
+    tr.set_allocation_limit(0);
+    bool thrown = false;
+    try {
+        (void)reader.next_batch(lines, 300, &tr);
+    }
+    catch (const std::pmr::test_resource_exception&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+    ASSERT(lines.empty());
+    tr.set_allocation_limit(-1);
+
+    std::pmr::monotonic_buffer_resource arena{ &tr };
+    ASSERT_EQ(reader.next_batch(lines, 300, &arena), 300u);
+    ASSERT_EQ(lines[0].str(), "symbol #0");
+    ASSERT_EQ(lines[299].str(), "symbol #299");
+}
+
+void empty_test(bool verbose)
+{
+    Framer framer{ "empty file", verbose };
+
+    TempFile file{ "" };
+
+    pstring_line_reader reader{ file.m_path_ };
+    ASSERT_EQ(reader.size(), 0u);
+
+    pstring line{ "untouched" };
+    ASSERT(!reader.next(line));
+    ASSERT_EQ(line.str(), "untouched");
+
+    std::pmr::vector<pstring> lines;
+    ASSERT_EQ(reader.next_batch(lines, 10,
+                                std::pmr::new_delete_resource()), 0u);
+}
+
+void error_test(bool verbose)
+{
+    Framer framer{ "missing file", verbose };
+
+    bool thrown = false;
+    try {
+        pstring_line_reader reader{ "/nonexistent/pstring_lines" };
+    }
+    catch (const std::system_error& e) {
+        thrown = true;
+        if (verbose) {
+            std::printf("%s\n", e.what());
+        }
+    }
+    ASSERT(thrown);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
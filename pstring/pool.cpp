@@ -0,0 +1,192 @@
+// pool.cpp                                                           -*-C++-*-
+#include <pstring_pool.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <cstdio>
+#include <string>
+
+void intern_test (bool verbose);
+void find_test   (bool verbose);
+void growth_test (bool verbose);
+void convert_test(bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    intern_test (verbose);
+    find_test   (verbose);
+    growth_test (verbose);
+    convert_test(verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void intern_test(bool verbose)
+{
+    Framer framer{ "intern", verbose };
+
+    std::pmr::test_resource tr{ "pool", verbose };
+
+    pstring_pool pool{ &tr };
+
+    pstring_pool::handle ibm   = pool.intern("IBM");
+    pstring_pool::handle msft  = pool.intern("MSFT US Equity");
+    pstring_pool::handle ibm2  = pool.intern(std::string{ "IBM" });
+    pstring_pool::handle empty = pool.intern("");
+
+    ASSERT((ibm == ibm2));
+    ASSERT((ibm != msft));
+    ASSERT((ibm != empty));
+    ASSERT(bool(empty));
+    ASSERT_EQ(pool.size(), 3u);
+
+    ASSERT_EQ(ibm.view(), "IBM");
+    ASSERT_EQ(msft.view(), "MSFT US Equity");
+    ASSERT_EQ(empty.size(), 0u);
+
+    // The interned characters are null terminated, and stay put.
+
+    ASSERT_EQ(ibm.view().data()[3], '\0');
+    ASSERT_EQ(ibm.view().data(), ibm2.view().data());
+
+    // An empty view may have no characters at all, not even a null pointer
+    // to compare or copy from.
+
+    ASSERT((pool.intern(std::string_view{}) == empty));
+    ASSERT_EQ(pool.size(), 3u);
+
+    pstring_pool fresh{ &tr };
+    pstring_pool::handle none = fresh.intern(std::string_view{});
+    ASSERT(bool(none));
+    ASSERT_EQ(none.size(), 0u);
+    ASSERT_EQ(none.view().data()[0], '\0');
+    ASSERT((fresh.intern("") == none));
+    ASSERT_EQ(fresh.size(), 1u);
+}
+
+void find_test(bool verbose)
+{
+    Framer framer{ "find", verbose };
+
+    std::pmr::test_resource          tr{ "pool" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    pstring_pool pool{ &tr };
+    pstring_pool::handle spx = pool.intern("SPX Index");
+    trm.reset();
+
+    ASSERT((pool.find("SPX Index") == spx));
+    ASSERT(!pool.find("SPX"));
+    ASSERT(!pool.find("SPX Index, but longer"));
+    ASSERT(!pstring_pool::handle{});
+    ASSERT_EQ(pool.size(), 1u);
+
+    // Neither finding, nor interning a string again, allocates.
+
+    pool.intern("SPX Index");
+    ASSERT(trm.is_total_same());
+}
+
+void growth_test(bool verbose)
+{
+    Framer framer{ "many strings", verbose };
+
+    std::pmr::test_resource tr{ "pool", verbose };
+
+    pstring_pool pool{ &tr };
+
+    // Enough strings to grow both the table and the arena several times.
+
+    char name[32];
+    pstring_pool::handle handles[5000];
+    for (int i = 0; i < 5000; ++i) {
+        std::snprintf(name, sizeof name, "symbol #%d", i);
+        handles[i] = pool.intern(name);
+    }
+    ASSERT_EQ(pool.size(), 5000u);
+
+    std::pmr::test_resource_monitor trm{ tr };
+
+    for (int i = 0; i < 5000; ++i) {
+        std::snprintf(name, sizeof name, "symbol #%d", i);
+        ASSERT((pool.intern(name) == handles[i]));
+        ASSERT_EQ(handles[i].view(), name);
+    }
+    ASSERT_EQ(pool.size(), 5000u);
+    ASSERT(trm.is_total_same());
+
+    // Strings longer than a chunk get a chunk of their own.
+
+    std::string huge(10000, 'x');
+    pstring_pool::handle big = pool.intern(huge);
+    ASSERT_EQ(big.view(), huge);
+    ASSERT((pool.find(huge) == big));
+}
+
+void convert_test(bool verbose)
+{
+    Framer framer{ "conversion", verbose };
+
+    std::pmr::test_resource tr{ "pool" };
+    tr.set_verbose(verbose);
+
+    std::pmr::test_resource          sr{ "string" };
+    std::pmr::test_resource_monitor srm{ sr };
+    sr.set_verbose(verbose);
+
+    pstring_pool pool{ &tr };
+
+    pstring_pool::handle ibm  = pool.intern("IBM");
+    pstring_pool::handle name = pool.intern("T 2 1/4 08/15/27 Govt, on the run");
+
+    std::string_view view = name;
+    ASSERT_EQ(view.data(), name.view().data());
+
+    pstring small = ibm.str(&sr);
+    ASSERT_EQ(small.str(), "IBM");
+    ASSERT(srm.is_total_same());
+
+    pstring large = name.str(&sr);
+    ASSERT_EQ(large.str(), "T 2 1/4 08/15/27 Govt, on the run");
+    ASSERT_EQ(large.get_allocator().resource(), &sr);
+
+    // Borrowing refers to the interned characters, and never allocates.
+
+    srm.reset();
+    pstring borrowed = name.borrow(&sr);
+    ASSERT(borrowed.is_static());
+    ASSERT_EQ(borrowed.data(), name.view().data());
+    ASSERT((borrowed == large));
+    ASSERT(srm.is_total_same());
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
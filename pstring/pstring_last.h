@@ -2,7 +2,928 @@
 #ifndef PSTRING_LAST_H_INCLUDED
 #define PSTRING_LAST_H_INCLUDED
 
-#include <pstring_stage9.h>
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+template <size_t N>
+class pstring_concat {
+    // This class holds the pieces of a chain of concatenations, such as
+    // 'a + b + c', so that the result can be measured and allocated once.
+    // Note that the pieces are not copied: a 'pstring_concat' must not
+    // outlive the full expression that creates it.
+
+    std::string_view m_pieces_[N];
+
+public:
+    template <class... VIEWS>
+    explicit pstring_concat(VIEWS... pieces)
+    : m_pieces_{ pieces... }
+    {
+    }
+
+    size_t size() const
+    {
+        size_t length = 0;
+        for (std::string_view piece : m_pieces_) {
+            length += piece.size();
+        }
+        return length;
+    }
+
+    bool overlaps(const char *begin, const char *end) const
+        // Return 'true' if a piece refers to characters in '[begin, end)'.
+    {
+        for (std::string_view piece : m_pieces_) {
+            if (piece.data() < end && begin < piece.data() + piece.size()) {
+                return true;                                          // RETURN
+            }
+        }
+        return false;
+    }
+
+    char *copy_to(char *buffer) const
+        // Copy the characters of all pieces to 'buffer', and return the
+        // address after the last one copied.
+    {
+        for (std::string_view piece : m_pieces_) {
+            std::memcpy(buffer, piece.data(), piece.size());
+            buffer += piece.size();
+        }
+        return buffer;
+    }
+
+    template <class STRING,
+              class = std::enable_if_t<
+                   std::is_convertible_v<const STRING&, std::string_view>>>
+    friend pstring_concat<N + 1> operator+(const pstring_concat& lhs,
+                                           const STRING&         rhs)
+    {
+        return lhs.append(std::string_view(rhs),
+                          std::make_index_sequence<N>());
+    }
+
+private:
+    template <size_t... INDICES>
+    pstring_concat<N + 1> append(std::string_view rhs,
+                                 std::index_sequence<INDICES...>) const
+    {
+        return pstring_concat<N + 1>(m_pieces_[INDICES]..., rhs);
+    }
+};
+
+class pstring {
+    // This class is for demonstration purposes *only*.
+    //
+    // Strings of up to 'small_capacity' characters are stored in a buffer
+    // inside the object, and never allocate memory.  Note that the allocator
+    // of a 'pstring' never changes, so a string stored in the small buffer
+    // is simply copied whatever allocators are involved.
+    //
+    // A string created with the 'static_storage' tag refers to characters
+    // that outlive it, such as a literal, instead of copying them.  Copies of
+    // such a string refer to the same characters, whatever their allocator;
+    // the first modification copies the characters to memory of its own.
+    //
+    // A string can also be made to share its characters: 'make_shared' moves
+    // them to a reference counted buffer, and from then on copies using the
+    // same allocator, and substrings, refer to that buffer.  Modifying a
+    // sharing string, or copying it with another allocator, copies the
+    // characters.  Note that the characters of a substring are not null
+    // terminated.
+
+public:
+    using allocator_type = std::pmr::polymorphic_allocator_P0339R5<>;
+
+    struct static_storage_t {
+        explicit static_storage_t() = default;
+    };
+
+    static constexpr static_storage_t static_storage{};
+
+    static constexpr size_t small_capacity = 23;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    pstring(const char *cstr, allocator_type allocator = {});
+
+    pstring(const char *chars, size_t length, allocator_type allocator = {});
+
+    explicit pstring(std::string_view chars, allocator_type allocator = {});
+
+    template <size_t N>
+    pstring(static_storage_t,
+            const char     (&literal)[N],
+            allocator_type   allocator = {}) noexcept
+    : pstring(static_storage, std::string_view{ literal, N - 1 }, allocator)
+    {
+    }
+
+    pstring(static_storage_t,
+            std::string_view chars,
+            allocator_type   allocator = {}) noexcept;
+        // Refer to 'chars' without copying them.  The behavior is undefined
+        // unless 'chars' outlive this object and all its copies.
+
+    pstring(const pstring& other, allocator_type allocator = {});
+
+    template <size_t N>
+    pstring(const pstring_concat<N>& expr, allocator_type allocator = {});
+        // Create the result of a chain of concatenations with exactly one
+        // allocation, or none if it fits the small buffer.
+
+    pstring(pstring&& other) noexcept;
+    pstring(pstring&& other, allocator_type allocator);
+
+    ~pstring();
+
+    pstring& operator=(const pstring& rhs);
+
+    pstring& operator=(pstring&& rhs);
+        // Take over the buffer of 'rhs' if the allocators compare equal, and
+        // copy its characters otherwise, allocating at most once.  Does not
+        // throw if the allocators compare equal.
+
+    template <size_t N>
+    pstring& operator=(const pstring_concat<N>& expr);
+        // Assign the result of a chain of concatenations, evaluated with at
+        // most one allocation, or none if it fits the current buffer.  The
+        // chain may refer to the characters of this object.
+
+    void swap(pstring& other);
+        // Exchange the values of this object and 'other'.  Does not throw if
+        // the allocators compare equal; otherwise each value is copied into
+        // memory from the allocator of its new owner.
+
+    friend void swap(pstring& a, pstring& b)
+    {
+        a.swap(b);
+    }
+
+    void make_shared();
+        // Move the characters of a string that does not fit the small buffer
+        // into a reference counted buffer, shared by its copies and
+        // substrings.  Does nothing to strings in the small buffer, or in
+        // static storage.
+
+    pstring substr(size_t pos, size_t count = npos) const;
+        // Return the at most 'count' characters starting at 'pos', using the
+        // allocator of this object.  The result refers to the characters of
+        // this object instead of copying them if they are shared or in
+        // static storage.  Throw 'std::out_of_range' if 'pos > size()'.
+
+    void reserve(size_t capacity);
+        // Make room for at least 'capacity' characters.
+
+    pstring& append(const char *chars, size_t length);
+        // Append 'length' 'chars', growing the capacity geometrically if
+        // needed.  'chars' may refer to the characters of this object.
+
+    pstring& append(std::string_view chars)
+    {
+        return append(chars.data(), chars.size());
+    }
+
+    pstring& operator+=(std::string_view chars)
+    {
+        return append(chars.data(), chars.size());
+    }
+
+    pstring& operator+=(const pstring& chars)
+    {
+        return append(chars.data(), chars.m_length_);
+    }
+
+    pstring& operator+=(const char *chars)
+    {
+        return append(chars, std::strlen(chars));
+    }
+
+    pstring& operator+=(char c)
+    {
+        return append(&c, 1);
+    }
+
+    friend pstring_concat<2> operator+(const pstring& a, const pstring& b)
+    {
+        return pstring_concat<2>(std::string_view(a), std::string_view(b));
+    }
+
+    friend pstring_concat<2> operator+(const pstring& a, const char *b)
+    {
+        return pstring_concat<2>(std::string_view(a), std::string_view(b));
+    }
+
+    friend pstring_concat<2> operator+(const char *a, const pstring& b)
+    {
+        return pstring_concat<2>(std::string_view(a), std::string_view(b));
+    }
+
+    friend pstring_concat<2> operator+(const pstring& a, std::string_view b)
+    {
+        return pstring_concat<2>(std::string_view(a), b);
+    }
+
+    friend pstring_concat<2> operator+(std::string_view a, const pstring& b)
+    {
+        return pstring_concat<2>(a, std::string_view(b));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_allocator_;
+    }
+
+    size_t size() const
+    {
+        return m_length_;
+    }
+
+    size_t capacity() const
+        // Return the number of characters that fit the current buffer.
+    {
+        return is_small() ? small_capacity : m_heap_.m_capacity_;
+    }
+
+    const char *data() const
+    {
+        return is_small() ? m_small_ : m_heap_.m_buffer_;
+    }
+
+    operator std::string_view() const
+    {
+        return { data(), m_length_ };
+    }
+
+    int compare(std::string_view other) const;
+        // Return a negative value, 0, or a positive value if this string is
+        // lexicographically less than, equal to, or greater than 'other'.
+
+    size_t hash() const;
+        // Return the hash value of this string.  The value is computed on
+        // first use and cached in the object until it is modified; the cache
+        // fits in padding, so it does not make 'pstring' bigger, and is
+        // atomic, so that several threads may hash the same string.
+
+    friend bool operator==(const pstring& a, const pstring& b)
+    {
+        if (a.m_length_ != b.m_length_) {
+            return false;                                             // RETURN
+        }
+        const unsigned aHash = a.m_hash_.load(std::memory_order_relaxed);
+        const unsigned bHash = b.m_hash_.load(std::memory_order_relaxed);
+        return (aHash == 0 || bHash == 0 || aHash == bHash) &&
+               equal_chars(a.data(), b.data(), a.m_length_);
+    }
+
+    friend bool operator!=(const pstring& a, const pstring& b)
+    {
+        return !(a == b);
+    }
+
+    friend bool operator<(const pstring& a, const pstring& b)
+    {
+        return a.compare(b) < 0;
+    }
+
+    friend bool operator>(const pstring& a, const pstring& b)
+    {
+        return a.compare(b) > 0;
+    }
+
+    friend bool operator<=(const pstring& a, const pstring& b)
+    {
+        return a.compare(b) <= 0;
+    }
+
+    friend bool operator>=(const pstring& a, const pstring& b)
+    {
+        return a.compare(b) >= 0;
+    }
+
+    bool is_small() const
+        // Return 'true' if the characters are stored inside the object.
+    {
+        return e_SMALL == m_representation_;
+    }
+
+    bool is_static() const
+        // Return 'true' if the characters are in storage not owned by this
+        // object.
+    {
+        return e_STATIC == m_representation_;
+    }
+
+    bool is_shared() const
+        // Return 'true' if the characters are in a reference counted buffer.
+    {
+        return e_SHARED == m_representation_;
+    }
+
+    std::string str() const
+        // For sanity checks only.
+    {
+        return { data(), m_length_ };
+    }
+
+private:
+    enum representation : unsigned char {
+        e_SMALL,  // characters in 'm_small_'
+        e_OWNED,  // characters in 'm_heap_', allocated by 'm_allocator_'
+        e_STATIC, // characters in 'm_heap_', never written nor deallocated
+        e_SHARED  // characters in 'm_heap_', in the buffer of 'm_block_'
+    };
+
+    struct shared_block {
+        std::atomic<size_t> m_count_;  // number of strings referring to it
+        size_t              m_size_;   // characters following this header
+    };
+
+    struct heap_buffer {
+        char         *m_buffer_;    // allocated characters
+        size_t        m_capacity_;  // characters that fit, not counting null
+        shared_block *m_block_;     // reference counted buffer, if shared
+    };
+
+    char *init(size_t length);
+        // Make this object able to hold 'length' characters, allocating if
+        // they do not fit the small buffer, and return the address to copy
+        // them to.  The behavior is undefined unless this object owns no
+        // memory.
+
+    void copy_init(const char *chars, size_t length);
+        // Make this object hold a copy of the specified 'length' 'chars'.
+        // The behavior is undefined unless this object owns no memory.
+
+    void assign(const char *chars, size_t length);
+        // Set the value of this object to the specified 'length' 'chars',
+        // reusing the current buffer if they fit.  The behavior is undefined
+        // unless 'chars' is outside the buffer of this object.
+
+    bool fits(size_t length) const
+        // Return 'true' if 'length' characters can be written to the current
+        // buffer.
+    {
+        return (e_SMALL == m_representation_ ||
+                e_OWNED == m_representation_) && length <= capacity();
+    }
+
+    bool can_share(const pstring& other) const
+        // Return 'true' if this object can refer to the characters of the
+        // specified 'other' instead of copying them.
+    {
+        return other.is_static() ||
+               (other.is_shared() && m_allocator_ == other.m_allocator_);
+    }
+
+    void share(const pstring& other);
+        // Refer to the same characters as the specified 'other'.  The
+        // behavior is undefined unless 'can_share(other)', and this object
+        // owns no memory.
+
+    void steal(pstring& other);
+        // Take over the representation of the specified 'other', leaving it
+        // empty.  The behavior is undefined unless this object owns no memory
+        // and the allocators compare equal.
+
+    void release();
+        // Deallocate the memory owned by this object, if any.
+
+    char *buffer()
+    {
+        return is_small() ? m_small_ : m_heap_.m_buffer_;
+    }
+
+    static bool equal_chars(const char *a, const char *b, size_t length);
+        // Return 'true' if the specified 'length' characters at 'a' and 'b'
+        // are equal.
+
+    void set_length(size_t length)
+        // Set the length of the value, which has changed.
+    {
+        m_length_ = length;
+        m_hash_.store(0, std::memory_order_relaxed);
+    }
+
+    char *allocate_buffer(size_t& capacity);
+        // Allocate a buffer for at least the specified 'capacity' characters
+        // and the terminating null, and set 'capacity' to the number of
+        // characters it has room for, using any slack the resource reports.
+
+    bool resize_buffer(size_t capacity);
+        // Resize in place the buffer owned by this object to room for the
+        // specified 'capacity' characters and the terminating null, and
+        // return 'true'; or return 'false' if this object owns no buffer or
+        // its resource cannot resize it in place.
+
+    void replace_buffer(char *buff, size_t capacity);
+        // Release the memory owned by this object, if any, and take over the
+        // specified 'buff', having room for 'capacity' characters and the
+        // terminating null, allocated by 'm_allocator_'.
+
+    allocator_type  m_allocator_;
+    size_t          m_length_;
+    union {
+        char        m_small_[small_capacity + 1];
+        heap_buffer m_heap_;
+    };
+    representation  m_representation_;
+    mutable std::atomic<unsigned>
+                    m_hash_;            // cached 'hash()', 0 if not computed
+};
+
+inline
+char *pstring::init(size_t length)
+{
+    set_length(length);
+
+    if (length <= small_capacity) {
+        m_representation_ = e_SMALL;
+        return m_small_;                                              // RETURN
+    }
+
+    m_heap_.m_buffer_   = m_allocator_.allocate_object<char>(length + 1);
+    m_heap_.m_capacity_ = length;
+    m_representation_   = e_OWNED;
+    return m_heap_.m_buffer_;
+}
+
+inline
+void pstring::copy_init(const char *chars, size_t length)
+{
+    char *buff = init(length);
+    std::memcpy(buff, chars, length);
+    buff[length] = '\0';
+}
+
+inline
+void pstring::assign(const char *chars, size_t length)
+{
+    if (fits(length)) {
+        // Reuse the current buffer, whichever it is.
+
+        char *buff = buffer();
+        std::memcpy(buff, chars, length);
+        buff[length] = '\0';
+        set_length(length);
+        return;                                                       // RETURN
+    }
+
+    if (length <= small_capacity) {
+        // Only static storage and shared buffers get here.
+
+        release();
+        std::memcpy(m_small_, chars, length);
+        m_small_[length]  = '\0';
+        m_representation_ = e_SMALL;
+        set_length(length);
+        return;                                                       // RETURN
+    }
+
+    // Allocate before releasing, so an exception leaves '*this' unchanged.
+
+    char *buff = m_allocator_.allocate_object<char>(length + 1);
+    std::memcpy(buff, chars, length);
+    buff[length] = '\0';
+    replace_buffer(buff, length);
+    set_length(length);
+}
+
+inline
+char *pstring::allocate_buffer(size_t& capacity)
+{
+    const std::pmr::allocation_result<void *> result =
+                       m_allocator_.allocate_bytes_at_least(capacity + 1, 1);
+    capacity = result.count - 1;
+    return static_cast<char *>(result.ptr);
+}
+
+inline
+bool pstring::resize_buffer(size_t capacity)
+{
+    if (e_OWNED != m_representation_ ||
+        !m_allocator_.try_resize_bytes(m_heap_.m_buffer_,
+                                       m_heap_.m_capacity_ + 1,
+                                       capacity + 1,
+                                       1)) {
+        return false;                                                 // RETURN
+    }
+
+    m_heap_.m_capacity_ = capacity;
+    return true;
+}
+
+inline
+void pstring::replace_buffer(char *buff, size_t capacity)
+{
+    release();
+    m_heap_.m_buffer_   = buff;
+    m_heap_.m_capacity_ = capacity;
+    m_representation_   = e_OWNED;
+}
+
+inline
+void pstring::share(const pstring& other)
+{
+    if (other.is_shared()) {
+        other.m_heap_.m_block_->m_count_.fetch_add(1,
+                                                   std::memory_order_relaxed);
+    }
+
+    m_length_         = other.m_length_;
+    m_hash_.store(other.m_hash_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+    m_heap_           = other.m_heap_;
+    m_representation_ = other.m_representation_;
+}
+
+inline
+void pstring::steal(pstring& other)
+{
+    static_assert(sizeof(heap_buffer) <= sizeof m_small_,
+                  "copying 'm_small_' must copy the whole union");
+
+    m_length_         = other.m_length_;
+    m_hash_.store(other.m_hash_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+    m_representation_ = other.m_representation_;
+    std::memcpy(m_small_, other.m_small_, sizeof m_small_);
+
+    other.set_length(0);
+    other.m_small_[0]       = '\0';
+    other.m_representation_ = e_SMALL;
+}
+
+inline
+void pstring::release()
+{
+    if (e_OWNED == m_representation_) {
+        m_allocator_.deallocate_object(m_heap_.m_buffer_,
+                                       m_heap_.m_capacity_ + 1);
+    }
+    else if (e_SHARED == m_representation_) {
+        shared_block *block = m_heap_.m_block_;
+        if (1 == block->m_count_.fetch_sub(1, std::memory_order_acq_rel)) {
+            const size_t bytes = sizeof(shared_block) + block->m_size_ + 1;
+            block->~shared_block();
+            m_allocator_.deallocate_bytes(block, bytes, alignof(shared_block));
+        }
+    }
+}
+
+inline
+pstring::pstring(const char *cstr, allocator_type allocator)
+: pstring(cstr, std::strlen(cstr), allocator)
+{
+}
+
+inline
+pstring::pstring(const char *chars, size_t length, allocator_type allocator)
+: m_allocator_(allocator)
+{
+    copy_init(chars, length);
+}
+
+inline
+pstring::pstring(std::string_view chars, allocator_type allocator)
+: pstring(chars.data(), chars.size(), allocator)
+{
+}
+
+inline
+pstring::pstring(static_storage_t,
+                 std::string_view chars,
+                 allocator_type   allocator) noexcept
+: m_allocator_(allocator)
+, m_length_(chars.size())
+, m_heap_{ const_cast<char *>(chars.data()), chars.size(), nullptr }
+, m_representation_(e_STATIC)
+, m_hash_(0)
+{
+}
+
+inline
+pstring::pstring(const pstring& other, allocator_type allocator)
+: m_allocator_(allocator)
+{
+    if (can_share(other)) {
+        share(other);
+        return;                                                       // RETURN
+    }
+
+    copy_init(other.data(), other.m_length_);
+}
+
+template <size_t N>
+inline
+pstring::pstring(const pstring_concat<N>& expr, allocator_type allocator)
+: m_allocator_(allocator)
+{
+    const size_t length = expr.size();
+
+    *expr.copy_to(init(length)) = '\0';
+}
+
+inline
+pstring::pstring(pstring&& other) noexcept
+: pstring(static_cast<pstring&&>(other), other.m_allocator_)
+{
+}
+
+inline
+pstring::pstring(pstring&& other, allocator_type allocator)
+: m_allocator_(allocator)
+{
+    if (other.is_small() ||
+        (!other.is_static() && m_allocator_ != other.m_allocator_)) {
+        // Copy, the buffer of 'other' (if any) cannot be ours.
+
+        copy_init(other.data(), other.m_length_);
+        return;                                                       // RETURN
+    }
+
+    steal(other);
+}
+
+inline
+pstring::~pstring()
+{
+    release();
+}
+
+inline
+pstring& pstring::operator=(const pstring& rhs)
+{
+    if (this == &rhs) {
+        return *this;                                                 // RETURN
+    }
+
+    if (can_share(rhs)) {
+        // 'rhs' holds a reference to the shared buffer, if any, so releasing
+        // ours first cannot free it.
+
+        release();
+        share(rhs);
+        return *this;                                                 // RETURN
+    }
+
+    assign(rhs.data(), rhs.m_length_);
+    return *this;
+}
+
+inline
+pstring& pstring::operator=(pstring&& rhs)
+{
+    if (this == &rhs) {
+        return *this;                                                 // RETURN
+    }
+
+    if (rhs.is_small() ||
+        (!rhs.is_static() && m_allocator_ != rhs.m_allocator_)) {
+        assign(rhs.data(), rhs.m_length_);
+        return *this;                                                 // RETURN
+    }
+
+    release();
+    steal(rhs);
+    return *this;
+}
+
+template <size_t N>
+inline
+pstring& pstring::operator=(const pstring_concat<N>& expr)
+{
+    const size_t length = expr.size();
+
+    if (fits(length) && !expr.overlaps(data(), data() + m_length_)) {
+        *expr.copy_to(buffer()) = '\0';
+        set_length(length);
+        return *this;                                                 // RETURN
+    }
+
+    // Build the result aside: it is larger than the buffer, or made of our
+    // own characters.
+
+    pstring result{ expr, m_allocator_ };
+    return *this = std::move(result);
+}
+
+inline
+void pstring::swap(pstring& other)
+{
+    if (m_allocator_ == other.m_allocator_) {
+        std::swap(m_length_, other.m_length_);
+        const unsigned hash = m_hash_.load(std::memory_order_relaxed);
+        m_hash_.store(other.m_hash_.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+        other.m_hash_.store(hash, std::memory_order_relaxed);
+        std::swap(m_representation_, other.m_representation_);
+        std::swap(m_small_, other.m_small_);
+        return;                                                       // RETURN
+    }
+
+    // Make both copies before modifying either object.
+
+    pstring mine  { *this, other.m_allocator_ };
+    pstring theirs{ other, m_allocator_ };
+
+    *this = std::move(theirs);
+    other = std::move(mine);
+}
+
+inline
+void pstring::make_shared()
+{
+    if (e_OWNED != m_representation_) {
+        return;                                                       // RETURN
+    }
+
+    void *raw = m_allocator_.allocate_bytes(
+                   sizeof(shared_block) + m_length_ + 1, alignof(shared_block));
+    shared_block *block = ::new (raw) shared_block{ { 1 }, m_length_ };
+
+    char *chars = reinterpret_cast<char *>(block + 1);
+    std::memcpy(chars, m_heap_.m_buffer_, m_length_);
+    chars[m_length_] = '\0';
+
+    release();
+    m_heap_           = heap_buffer{ chars, m_length_, block };
+    m_representation_ = e_SHARED;
+}
+
+inline
+pstring pstring::substr(size_t pos, size_t count) const
+{
+    if (pos > m_length_) {
+        throw std::out_of_range("pstring::substr");
+    }
+    count = std::min(count, m_length_ - pos);
+
+    if (!is_static() && !is_shared()) {
+        return pstring{ data() + pos, count, m_allocator_ };          // RETURN
+    }
+
+    // Start from an empty string, which owns nothing, and refer to our
+    // characters.
+
+    pstring result{ static_storage, std::string_view{}, m_allocator_ };
+    result.share(*this);
+    result.m_heap_.m_buffer_   += pos;
+    result.m_heap_.m_capacity_  = count;
+    result.set_length(count);
+    return result;
+}
+
+inline
+void pstring::reserve(size_t capacity)
+{
+    if (capacity <= this->capacity()) {
+        return;                                                       // RETURN
+    }
+
+    if (resize_buffer(capacity)) {
+        return;                                                       // RETURN
+    }
+
+    char *buff = allocate_buffer(capacity);
+    std::memcpy(buff, data(), m_length_);
+    buff[m_length_] = '\0';
+    replace_buffer(buff, capacity);
+}
+
+inline
+pstring& pstring::append(const char *chars, size_t length)
+{
+    const size_t newLength = m_length_ + length;
+
+    if (fits(newLength)) {
+        char *buff = buffer();
+        std::memmove(buff + m_length_, chars, length);
+        buff[newLength] = '\0';
+        set_length(newLength);
+        return *this;                                                 // RETURN
+    }
+
+    if (newLength <= small_capacity) {
+        // Only static storage and shared buffers get here.  Build the result
+        // aside, as 'chars' may be part of the buffer we release.
+
+        char small[small_capacity + 1];
+        std::memcpy(small, data(), m_length_);
+        std::memcpy(small + m_length_, chars, length);
+        small[newLength] = '\0';
+
+        release();
+        std::memcpy(m_small_, small, newLength + 1);
+        m_representation_ = e_SMALL;
+        set_length(newLength);
+        return *this;                                                 // RETURN
+    }
+
+    // Grow geometrically, so that appending one character at a time costs
+    // amortized constant time.  Copy 'chars' before releasing the current
+    // buffer, as they may be part of it.
+
+    size_t newCapacity = std::max(newLength, 2 * capacity());
+
+    if (resize_buffer(newCapacity)) {
+        // The characters stay in place, so 'chars' is still valid.
+
+        char *buff = buffer();
+        std::memmove(buff + m_length_, chars, length);
+        buff[newLength] = '\0';
+        set_length(newLength);
+        return *this;                                                 // RETURN
+    }
+
+    char *buff = allocate_buffer(newCapacity);
+    std::memcpy(buff, data(), m_length_);
+    std::memcpy(buff + m_length_, chars, length);
+    buff[newLength] = '\0';
+    replace_buffer(buff, newCapacity);
+    set_length(newLength);
+
+    return *this;
+}
+
+inline
+bool pstring::equal_chars(const char *a, const char *b, size_t length)
+{
+#ifdef __SSE2__
+    // Compare 16 characters per instruction; the last block overlaps the
+    // previous one instead of falling back to a scalar loop.
+
+    if (length >= 16) {
+        const char *aLast = a + length - 16;
+        const char *bLast = b + length - 16;
+
+        for (;;) {
+            const __m128i eq = _mm_cmpeq_epi8(
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(a)),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(b)));
+            if (0xFFFF != _mm_movemask_epi8(eq)) {
+                return false;                                         // RETURN
+            }
+            if (a == aLast) {
+                return true;                                          // RETURN
+            }
+            a = std::min(a + 16, aLast);
+            b = std::min(b + 16, bLast);
+        }
+    }
+#endif
+    return 0 == std::memcmp(a, b, length);
+}
+
+inline
+int pstring::compare(std::string_view other) const
+{
+    const size_t length = std::min(m_length_, other.size());
+
+    if (const int rc = std::memcmp(data(), other.data(), length)) {
+        return rc;                                                    // RETURN
+    }
+    return m_length_ < other.size() ? -1 : m_length_ > other.size() ? 1 : 0;
+}
+
+inline
+size_t pstring::hash() const
+{
+    unsigned result = m_hash_.load(std::memory_order_relaxed);
+    if (0 == result) {
+        // Fold the hash to fit the cache; 0 means "not computed".  Threads
+        // racing here compute and store the same value.
+
+        const size_t full = std::hash<std::string_view>()(*this);
+        result = static_cast<unsigned>(full ^ (full >> sizeof full * 4)) | 1u;
+        m_hash_.store(result, std::memory_order_relaxed);
+    }
+    return result;
+}
+
+namespace std {
+
+template <>
+struct hash<pstring> {
+    size_t operator()(const pstring& s) const
+    {
+        return s.hash();
+    }
+};
+
+}  // close namespace std
 
 #endif
 
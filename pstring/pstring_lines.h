@@ -0,0 +1,213 @@
+// pstring_lines.h                                                    -*-C++-*-
+#ifndef PSTRING_LINES_H_INCLUDED
+#define PSTRING_LINES_H_INCLUDED
+
+#include <pstring_last.h>
+
+#include <memory_resource_p1160>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class pstring_line_reader {
+    // This class is for demonstration purposes *only*.
+    //
+    // Read the lines of a file mapped into memory.  The lines are returned as
+    // 'pstring' objects in static storage, referring to the mapping instead
+    // of copying it, so they must not outlive the reader.  Lines that must
+    // outlive it can be copied in batches into memory from an arena, one
+    // allocation per batch.  The line terminators, "\n" or "\r\n", are not
+    // part of the lines.
+
+public:
+    explicit pstring_line_reader(const char *path);
+        // Map the file at 'path'.  Throw 'std::system_error' on failure.
+
+    pstring_line_reader(const pstring_line_reader&) = delete;
+    pstring_line_reader& operator=(const pstring_line_reader&) = delete;
+
+    ~pstring_line_reader();
+
+    bool next(std::string_view& line);
+        // Set 'line' to the next line and return 'true', or return 'false' if
+        // there are no more lines.
+
+    bool next(pstring& line);
+        // Set 'line' to refer to the next line and return 'true', or return
+        // 'false' if there are no more lines.  Does not allocate.
+
+    template <class VECTOR>
+    size_t next_batch(VECTOR&                     lines,
+                      size_t                      count,
+                      std::pmr::memory_resource  *arena);
+        // Append at most 'count' of the next lines to 'lines', a vector of
+        // 'pstring', and return how many were appended.  The lines are copied
+        // at once into one block allocated from 'arena', which is never
+        // deallocated by this object: the behavior is undefined unless
+        // 'arena' (typically a 'monotonic_buffer_resource') outlives them.
+
+    size_t size() const
+        // Return the size of the file.
+    {
+        return m_size_;
+    }
+
+private:
+    static bool split(const char       *&next,
+                      const char        *end,
+                      std::string_view&  line);
+        // Set 'line' to the line starting at 'next', and 'next' past its end,
+        // and return 'true', or return 'false' if 'next == end'.
+
+    const char *m_begin_{ nullptr };  // the mapping, 'nullptr' if empty
+    const char *m_next_{ nullptr };   // the start of the next line
+    const char *m_end_{ nullptr };
+    size_t      m_size_{ 0 };
+};
+
+inline
+pstring_line_reader::pstring_line_reader(const char *path)
+{
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) < 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+    m_size_ = static_cast<size_t>(status.st_size);
+
+    if (0 == m_size_) {
+        // An empty file cannot be mapped, and has no lines.
+
+        ::close(fd);
+        return;                                                       // RETURN
+    }
+
+    void *mapping = ::mmap(nullptr, m_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (MAP_FAILED == mapping) {
+        throw std::system_error(error, std::generic_category(), path);
+    }
+
+    // Advise the kernel that the file is read sequentially, so it reads
+    // ahead aggressively.  The advice is only advice: ignore failures.
+
+    ::madvise(mapping, m_size_, MADV_SEQUENTIAL);
+
+    m_begin_ = static_cast<const char *>(mapping);
+    m_next_  = m_begin_;
+    m_end_   = m_begin_ + m_size_;
+}
+
+inline
+pstring_line_reader::~pstring_line_reader()
+{
+    if (m_begin_) {
+        ::munmap(const_cast<char *>(m_begin_), m_size_);
+    }
+}
+
+inline
+bool pstring_line_reader::split(const char       *&next,
+                                const char        *end,
+                                std::string_view&  line)
+{
+    if (next == end) {
+        return false;                                                 // RETURN
+    }
+
+    const char *newline = static_cast<const char *>(
+                                    std::memchr(next, '\n', end - next));
+
+    line = std::string_view(next, (newline ? newline : end) - next);
+    if (!line.empty() && '\r' == line.back()) {
+        line.remove_suffix(1);
+    }
+
+    next = newline ? newline + 1 : end;
+    return true;
+}
+
+inline
+bool pstring_line_reader::next(std::string_view& line)
+{
+    return split(m_next_, m_end_, line);
+}
+
+inline
+bool pstring_line_reader::next(pstring& line)
+{
+    std::string_view chars;
+    if (!next(chars)) {
+        return false;                                                 // RETURN
+    }
+
+    line = pstring{ pstring::static_storage, chars, line.get_allocator() };
+    return true;
+}
+
+template <class VECTOR>
+inline
+size_t pstring_line_reader::next_batch(VECTOR&                     lines,
+                                       size_t                      count,
+                                       std::pmr::memory_resource  *arena)
+{
+    // Find the end of the batch, then copy it at once, terminators
+    // included, and split the copy.  The reader moves on only once the copy
+    // is allocated, so a failed batch can be read again.
+
+    const char      *start = m_next_;
+    const char      *end   = m_next_;
+    size_t           found = 0;
+    std::string_view line;
+    while (found < count && split(end, m_end_, line)) {
+        ++found;
+    }
+
+    if (0 == found) {
+        return 0;                                                     // RETURN
+    }
+
+    const size_t  bytes = end - start;
+    char         *block = static_cast<char *>(arena->allocate(bytes, 1));
+    std::memcpy(block, start, bytes);
+    m_next_ = end;
+
+    const char *position = block;
+    while (split(position, block + bytes, line)) {
+        lines.emplace_back(pstring::static_storage, line);
+    }
+
+    return found;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,315 @@
+// pstring_pool.h                                                     -*-C++-*-
+#ifndef PSTRING_POOL_H_INCLUDED
+#define PSTRING_POOL_H_INCLUDED
+
+#include <pstring_last.h>
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+class pstring_pool {
+    // This class is for demonstration purposes *only*.
+    //
+    // An interning table: every distinct string is stored once, in large
+    // chunks of memory that are only released when the pool is destroyed,
+    // and is found through an open-addressing hash table.  Interning hands
+    // out a 'handle', the size of a pointer, that compares equal to another
+    // handle exactly when the strings are equal.
+
+    struct record {
+        size_t   m_length_;  // number of characters
+        size_t   m_hash_;    // hash of the characters
+        // Followed by the characters and a terminating null.
+
+        const char *chars() const
+        {
+            return reinterpret_cast<const char *>(this + 1);
+        }
+    };
+
+    struct slot {
+        size_t        m_hash_;    // hash of the record, to skip most compares
+        const record *m_record_;  // the interned string, 'nullptr' if empty
+    };
+
+    struct chunk {
+        chunk  *m_next_;  // previously allocated chunk
+        size_t  m_size_;  // bytes in this chunk, including this header
+    };
+
+public:
+    using allocator_type = std::pmr::polymorphic_allocator_P0339R5<>;
+
+    class handle {
+        const record *m_record_{ nullptr };
+
+        friend class pstring_pool;
+
+        explicit handle(const record *rec)
+        : m_record_(rec)
+        {
+        }
+
+    public:
+        handle() = default;
+
+        explicit operator bool() const
+        {
+            return nullptr != m_record_;
+        }
+
+        size_t size() const
+        {
+            return m_record_ ? m_record_->m_length_ : 0;
+        }
+
+        std::string_view view() const
+            // Return the interned characters, valid as long as the pool.
+        {
+            return m_record_
+                 ? std::string_view{ m_record_->chars(), m_record_->m_length_ }
+                 : std::string_view{};
+        }
+
+        operator std::string_view() const
+        {
+            return view();
+        }
+
+        pstring str(pstring::allocator_type allocator = {}) const
+            // Return a 'pstring' holding a copy of the characters.
+        {
+            return pstring{ view(), allocator };
+        }
+
+        pstring borrow(pstring::allocator_type allocator = {}) const
+            // Return a 'pstring' referring to the interned characters,
+            // without copying them.  The behavior is undefined unless the
+            // result, and all its copies, are destroyed before the pool.
+        {
+            return pstring{ pstring::static_storage, view(), allocator };
+        }
+
+        friend bool operator==(handle a, handle b)
+        {
+            return a.m_record_ == b.m_record_;
+        }
+
+        friend bool operator!=(handle a, handle b)
+        {
+            return a.m_record_ != b.m_record_;
+        }
+    };
+
+    explicit pstring_pool(allocator_type allocator = {});
+
+    pstring_pool(const pstring_pool&) = delete;
+    pstring_pool& operator=(const pstring_pool&) = delete;
+
+    ~pstring_pool();
+
+    handle intern(std::string_view chars);
+        // Return the handle of 'chars', storing them if they are new.
+
+    handle find(std::string_view chars) const;
+        // Return the handle of 'chars', or a null handle if not interned.
+
+    size_t size() const
+        // Return the number of distinct strings interned.
+    {
+        return m_size_;
+    }
+
+    size_t bytes_used() const
+        // Return the number of bytes used to store the strings.
+    {
+        return m_bytes_used_;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_allocator_;
+    }
+
+private:
+    static constexpr size_t initial_chunk_size = 4096;
+    static constexpr size_t initial_slots      = 64;
+
+    const slot *lookup(std::string_view chars, size_t hash) const;
+        // Return the slot holding 'chars', or the empty slot where they
+        // would be stored.
+
+    const record *store(std::string_view chars, size_t hash);
+        // Copy 'chars' into the arena and return their record.
+
+    void grow_table();
+        // Double the number of slots, and rehash.
+
+    allocator_type  m_allocator_;
+    slot           *m_slots_{ nullptr };
+    size_t          m_slot_count_{ 0 };   // always a power of 2
+    size_t          m_size_{ 0 };
+    chunk          *m_chunks_{ nullptr };
+    char           *m_next_byte_{ nullptr };
+    size_t          m_bytes_left_{ 0 };
+    size_t          m_bytes_used_{ 0 };
+};
+
+inline
+pstring_pool::pstring_pool(allocator_type allocator)
+: m_allocator_(allocator)
+{
+    m_slots_      = m_allocator_.allocate_object<slot>(initial_slots);
+    m_slot_count_ = initial_slots;
+    std::fill_n(m_slots_, m_slot_count_, slot{ 0, nullptr });
+}
+
+inline
+pstring_pool::~pstring_pool()
+{
+    m_allocator_.deallocate_object(m_slots_, m_slot_count_);
+
+    while (m_chunks_) {
+        chunk *next = m_chunks_->m_next_;
+        m_allocator_.deallocate_bytes(m_chunks_,
+                                      m_chunks_->m_size_,
+                                      alignof(record));
+        m_chunks_ = next;
+    }
+}
+
+inline
+const pstring_pool::slot *pstring_pool::lookup(std::string_view chars,
+                                                size_t           hash) const
+{
+    const size_t mask = m_slot_count_ - 1;
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const slot& candidate = m_slots_[i];
+        if (!candidate.m_record_ ||
+            (candidate.m_hash_ == hash &&
+             candidate.m_record_->m_length_ == chars.size() &&
+             (chars.empty() ||
+              0 == std::memcmp(candidate.m_record_->chars(),
+                               chars.data(),
+                               chars.size())))) {
+            return &candidate;                                        // RETURN
+        }
+    }
+}
+
+inline
+const pstring_pool::record *pstring_pool::store(std::string_view chars,
+                                                 size_t           hash)
+{
+    const size_t needed = (sizeof(record) + chars.size() + 1 +
+                           alignof(record) - 1) & ~(alignof(record) - 1);
+
+    if (needed > m_bytes_left_) {
+        // Start a new chunk, twice as big as the previous one, and at least
+        // big enough for this string.
+
+        const size_t size = std::max(
+                        m_chunks_ ? 2 * m_chunks_->m_size_ : initial_chunk_size,
+                        sizeof(chunk) + needed);
+
+        chunk *fresh = static_cast<chunk *>(
+                            m_allocator_.allocate_bytes(size, alignof(record)));
+        fresh->m_next_ = m_chunks_;
+        fresh->m_size_ = size;
+        m_chunks_      = fresh;
+        m_next_byte_   = reinterpret_cast<char *>(fresh + 1);
+        m_bytes_left_  = size - sizeof(chunk);
+    }
+
+    record *rec = reinterpret_cast<record *>(m_next_byte_);
+    rec->m_length_ = chars.size();
+    rec->m_hash_   = hash;
+
+    char *dest = m_next_byte_ + sizeof(record);
+    if (!chars.empty()) {
+        std::memcpy(dest, chars.data(), chars.size());
+    }
+    dest[chars.size()] = '\0';
+
+    m_next_byte_  += needed;
+    m_bytes_left_ -= needed;
+    m_bytes_used_ += needed;
+
+    return rec;
+}
+
+inline
+void pstring_pool::grow_table()
+{
+    const size_t count = 2 * m_slot_count_;
+    slot        *slots = m_allocator_.allocate_object<slot>(count);
+    std::fill_n(slots, count, slot{ 0, nullptr });
+
+    for (size_t i = 0; i < m_slot_count_; ++i) {
+        if (m_slots_[i].m_record_) {
+            size_t j = m_slots_[i].m_hash_ & (count - 1);
+            while (slots[j].m_record_) {
+                j = (j + 1) & (count - 1);
+            }
+            slots[j] = m_slots_[i];
+        }
+    }
+
+    m_allocator_.deallocate_object(m_slots_, m_slot_count_);
+    m_slots_      = slots;
+    m_slot_count_ = count;
+}
+
+inline
+pstring_pool::handle pstring_pool::intern(std::string_view chars)
+{
+    const size_t hash = std::hash<std::string_view>()(chars);
+
+    slot *found = const_cast<slot *>(lookup(chars, hash));
+    if (found->m_record_) {
+        return handle{ found->m_record_ };                            // RETURN
+    }
+
+    // Keep the load factor at most 1/2, so probe sequences stay short.
+
+    if (2 * (m_size_ + 1) > m_slot_count_) {
+        grow_table();
+        found = const_cast<slot *>(lookup(chars, hash));
+    }
+
+    found->m_record_ = store(chars, hash);
+    found->m_hash_   = hash;
+    ++m_size_;
+
+    return handle{ found->m_record_ };
+}
+
+inline
+pstring_pool::handle pstring_pool::find(std::string_view chars) const
+{
+    return handle{
+           lookup(chars, std::hash<std::string_view>()(chars))->m_record_ };
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -7,6 +7,11 @@
 #include <cstring>
 #include <string>
 
+// The stage 9 'pstring' has a namespace of its own, so that a benchmark can
+// compare it with the final 'pstring' in one program.
+
+namespace stage9 {
+
 class pstring {
     // This class is for demonstration purposes *only*.
 
@@ -104,6 +109,8 @@ pstring& pstring::operator=(const pstring& rhs)
     return *this;
 }
 
+}  // close namespace stage9
+
 #endif
 
 // ----------------------------------------------------------------------------
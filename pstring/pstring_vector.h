@@ -0,0 +1,491 @@
+// pstring_vector.h                                                   -*-C++-*-
+#ifndef PSTRING_VECTOR_H_INCLUDED
+#define PSTRING_VECTOR_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+class pstring_vector {
+    // This class is for demonstration purposes *only*.
+    //
+    // A sequence of strings stored in columns: the characters of all strings
+    // are in one buffer, one after the other, and their offsets and lengths
+    // are in a second one.  Adding a string allocates only when one of the
+    // buffers has to grow, which it does geometrically, and sorting or
+    // removing duplicates moves only the offsets and lengths.  Note that the
+    // characters are not null terminated.
+
+    struct entry {
+        size_t m_offset_;  // position of the first character in 'm_chars_'
+        size_t m_length_;  // number of characters
+    };
+
+public:
+    using allocator_type = std::pmr::polymorphic_allocator_P0339R5<>;
+    using value_type     = std::string_view;
+    using size_type      = size_t;
+
+    class const_iterator {
+        const entry *m_entry_{ nullptr };
+        const char  *m_chars_{ nullptr };
+
+        friend class pstring_vector;
+
+        const_iterator(const entry *ent, const char *chars)
+        : m_entry_(ent)
+        , m_chars_(chars)
+        {
+        }
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = std::string_view;
+
+        const_iterator() = default;
+
+        std::string_view operator*() const
+        {
+            return { m_chars_ + m_entry_->m_offset_, m_entry_->m_length_ };
+        }
+
+        std::string_view operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        const_iterator& operator++()
+        {
+            ++m_entry_;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator result{ *this };
+            ++m_entry_;
+            return result;
+        }
+
+        const_iterator& operator--()
+        {
+            --m_entry_;
+            return *this;
+        }
+
+        const_iterator operator--(int)
+        {
+            const_iterator result{ *this };
+            --m_entry_;
+            return result;
+        }
+
+        const_iterator& operator+=(difference_type n)
+        {
+            m_entry_ += n;
+            return *this;
+        }
+
+        const_iterator& operator-=(difference_type n)
+        {
+            m_entry_ -= n;
+            return *this;
+        }
+
+        friend const_iterator operator+(const_iterator it, difference_type n)
+        {
+            return it += n;
+        }
+
+        friend const_iterator operator+(difference_type n, const_iterator it)
+        {
+            return it += n;
+        }
+
+        friend const_iterator operator-(const_iterator it, difference_type n)
+        {
+            return it -= n;
+        }
+
+        friend difference_type operator-(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ - b.m_entry_;
+        }
+
+        friend bool operator==(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ == b.m_entry_;
+        }
+
+        friend bool operator!=(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ != b.m_entry_;
+        }
+
+        friend bool operator<(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ < b.m_entry_;
+        }
+
+        friend bool operator>(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ > b.m_entry_;
+        }
+
+        friend bool operator<=(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ <= b.m_entry_;
+        }
+
+        friend bool operator>=(const_iterator a, const_iterator b)
+        {
+            return a.m_entry_ >= b.m_entry_;
+        }
+    };
+
+    using iterator = const_iterator;
+
+    explicit pstring_vector(allocator_type allocator = {});
+
+    pstring_vector(const pstring_vector& other, allocator_type allocator = {});
+
+    pstring_vector(pstring_vector&& other) noexcept;
+
+    pstring_vector& operator=(const pstring_vector&) = delete;
+
+    ~pstring_vector();
+
+    void reserve(size_t count, size_t chars);
+        // Make room for at least 'count' strings having 'chars' characters
+        // altogether.
+
+    void push_back(std::string_view chars);
+        // Append a copy of 'chars', which may be an element of this object.
+
+    template <class INPUT_ITERATOR>
+    void append(INPUT_ITERATOR first, INPUT_ITERATOR last);
+        // Append a copy of each string in '[first, last)', which may be a
+        // range of this object, or, for forward iterators, views of its
+        // strings.  Forward iterators are traversed twice, so that each
+        // buffer grows at most once.
+
+    void sort();
+        // Sort the strings in lexicographic order.
+
+    void dedup();
+        // Remove all but the first of each run of equal strings, so a sorted
+        // object keeps one copy of each string.  The characters of removed
+        // strings are not reclaimed.
+
+    void clear();
+        // Remove all strings, keeping the buffers.
+
+    size_t size() const
+    {
+        return m_size_;
+    }
+
+    bool empty() const
+    {
+        return 0 == m_size_;
+    }
+
+    size_t chars_size() const
+        // Return the number of characters stored, including those of removed
+        // duplicates.
+    {
+        return m_chars_size_;
+    }
+
+    std::string_view operator[](size_t index) const
+    {
+        return { m_chars_ + m_entries_[index].m_offset_,
+                 m_entries_[index].m_length_ };
+    }
+
+    const_iterator begin() const
+    {
+        return { m_entries_, m_chars_ };
+    }
+
+    const_iterator end() const
+    {
+        return { m_entries_ + m_size_, m_chars_ };
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_allocator_;
+    }
+
+private:
+    void grow_entries(size_t count);
+        // Make room for at least 'count' entries, growing geometrically.
+
+    size_t grown_chars_capacity(size_t chars) const
+        // Return the capacity of the character buffer grown geometrically
+        // to room for at least 'chars' characters.
+    {
+        return std::max({ chars, 2 * m_chars_capacity_, size_t(256) });
+    }
+
+    void grow_chars(size_t chars, std::string_view keep);
+        // Make room for at least 'chars' characters, growing geometrically.
+        // Deallocate the old buffer only after the characters of 'keep',
+        // which may be inside it, are appended to the new one.
+
+    bool owns_chars(std::string_view chars) const
+        // Return 'true' if 'chars' are inside the character buffer.
+    {
+        std::less<const char *> before;
+        return !chars.empty() &&
+               !before(chars.data(), m_chars_) &&
+               before(chars.data(), m_chars_ + m_chars_capacity_);
+    }
+
+    allocator_type  m_allocator_;
+    entry          *m_entries_{ nullptr };
+    size_t          m_size_{ 0 };
+    size_t          m_capacity_{ 0 };
+    char           *m_chars_{ nullptr };
+    size_t          m_chars_size_{ 0 };
+    size_t          m_chars_capacity_{ 0 };
+};
+
+inline
+pstring_vector::pstring_vector(allocator_type allocator)
+: m_allocator_(allocator)
+{
+}
+
+inline
+pstring_vector::pstring_vector(const pstring_vector& other,
+                               allocator_type        allocator)
+: m_allocator_(allocator)
+{
+    // Copy the characters of the remaining strings only, so copying also
+    // reclaims the characters of removed duplicates.
+
+    append(other.begin(), other.end());
+}
+
+inline
+pstring_vector::pstring_vector(pstring_vector&& other) noexcept
+: m_allocator_(other.m_allocator_)
+, m_entries_(std::exchange(other.m_entries_, nullptr))
+, m_size_(std::exchange(other.m_size_, 0))
+, m_capacity_(std::exchange(other.m_capacity_, 0))
+, m_chars_(std::exchange(other.m_chars_, nullptr))
+, m_chars_size_(std::exchange(other.m_chars_size_, 0))
+, m_chars_capacity_(std::exchange(other.m_chars_capacity_, 0))
+{
+}
+
+inline
+pstring_vector::~pstring_vector()
+{
+    if (m_entries_) {
+        m_allocator_.deallocate_object(m_entries_, m_capacity_);
+    }
+    if (m_chars_) {
+        m_allocator_.deallocate_object(m_chars_, m_chars_capacity_);
+    }
+}
+
+inline
+void pstring_vector::grow_entries(size_t count)
+{
+    const size_t capacity = std::max({ count, 2 * m_capacity_, size_t(16) });
+
+    entry *entries = m_allocator_.allocate_object<entry>(capacity);
+    if (m_entries_) {
+        std::memcpy(entries, m_entries_, m_size_ * sizeof(entry));
+        m_allocator_.deallocate_object(m_entries_, m_capacity_);
+    }
+    m_entries_  = entries;
+    m_capacity_ = capacity;
+}
+
+inline
+void pstring_vector::grow_chars(size_t chars, std::string_view keep)
+{
+    const size_t capacity = grown_chars_capacity(chars);
+
+    char *buff = m_allocator_.allocate_object<char>(capacity);
+    if (!keep.empty()) {
+        std::memcpy(buff + m_chars_size_, keep.data(), keep.size());
+    }
+    if (m_chars_) {
+        std::memcpy(buff, m_chars_, m_chars_size_);
+        m_allocator_.deallocate_object(m_chars_, m_chars_capacity_);
+    }
+    m_chars_          = buff;
+    m_chars_capacity_ = capacity;
+}
+
+inline
+void pstring_vector::reserve(size_t count, size_t chars)
+{
+    if (count > m_capacity_) {
+        grow_entries(count);
+    }
+    if (chars > m_chars_capacity_) {
+        grow_chars(chars, {});
+    }
+}
+
+inline
+void pstring_vector::push_back(std::string_view chars)
+{
+    if (m_size_ == m_capacity_) {
+        grow_entries(m_size_ + 1);
+    }
+
+    if (m_chars_size_ + chars.size() > m_chars_capacity_) {
+        grow_chars(m_chars_size_ + chars.size(), chars);
+    }
+    else if (!chars.empty()) {
+        std::memmove(m_chars_ + m_chars_size_, chars.data(), chars.size());
+    }
+
+    m_entries_[m_size_++] = entry{ m_chars_size_, chars.size() };
+    m_chars_size_ += chars.size();
+}
+
+template <class INPUT_ITERATOR>
+inline
+void pstring_vector::append(INPUT_ITERATOR first, INPUT_ITERATOR last)
+{
+    using category =
+             typename std::iterator_traits<INPUT_ITERATOR>::iterator_category;
+
+    if constexpr (std::is_same_v<INPUT_ITERATOR, const_iterator>) {
+        // The iterators of this object are invalidated as its buffers grow:
+        // walk a range of its own strings by index.
+
+        std::less_equal<const entry *> notAfter;
+        if (first != last &&
+            notAfter(m_entries_, first.m_entry_) &&
+            notAfter(first.m_entry_, m_entries_ + m_size_)) {
+            const size_t begin = first.m_entry_ - m_entries_;
+            const size_t end   = last.m_entry_ - m_entries_;
+
+            size_t chars = 0;
+            for (size_t i = begin; i != end; ++i) {
+                chars += m_entries_[i].m_length_;
+            }
+            reserve(m_size_ + (end - begin), m_chars_size_ + chars);
+
+            for (size_t i = begin; i != end; ++i) {
+                push_back((*this)[i]);
+            }
+            return;                                                   // RETURN
+        }
+    }
+
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        size_t count   = 0;
+        size_t chars   = 0;
+        bool   aliased = false;
+        for (INPUT_ITERATOR it = first; it != last; ++it) {
+            const std::string_view view{ *it };
+            ++count;
+            chars   += view.size();
+            aliased  = aliased || owns_chars(view);
+        }
+
+        if (!aliased || m_chars_size_ + chars <= m_chars_capacity_) {
+            reserve(m_size_ + count, m_chars_size_ + chars);
+        }
+        else {
+            // Some strings are views of our own characters: copy them all
+            // to the grown buffer before deallocating the old one.
+
+            if (m_size_ + count > m_capacity_) {
+                grow_entries(m_size_ + count);
+            }
+
+            char         *old         = m_chars_;
+            const size_t  oldCapacity = m_chars_capacity_;
+            const size_t  capacity    = grown_chars_capacity(m_chars_size_ +
+                                                             chars);
+
+            m_chars_ = m_allocator_.allocate_object<char>(capacity);
+            std::memcpy(m_chars_, old, m_chars_size_);
+            m_chars_capacity_ = capacity;
+
+            for (; first != last; ++first) {
+                push_back(std::string_view(*first));
+            }
+            m_allocator_.deallocate_object(old, oldCapacity);
+            return;                                                   // RETURN
+        }
+    }
+
+    for (; first != last; ++first) {
+        push_back(std::string_view(*first));
+    }
+}
+
+inline
+void pstring_vector::sort()
+{
+    const char *chars = m_chars_;
+    std::sort(m_entries_,
+              m_entries_ + m_size_,
+              [chars](const entry& a, const entry& b) {
+                  return std::string_view(chars + a.m_offset_, a.m_length_) <
+                         std::string_view(chars + b.m_offset_, b.m_length_);
+              });
+}
+
+inline
+void pstring_vector::dedup()
+{
+    const char *chars = m_chars_;
+    entry *last = std::unique(
+               m_entries_,
+               m_entries_ + m_size_,
+               [chars](const entry& a, const entry& b) {
+                   return a.m_length_ == b.m_length_ &&
+                          (0 == a.m_length_ ||
+                           0 == std::memcmp(chars + a.m_offset_,
+                                            chars + b.m_offset_,
+                                            a.m_length_));
+               });
+    m_size_ = last - m_entries_;
+}
+
+inline
+void pstring_vector::clear()
+{
+    m_size_       = 0;
+    m_chars_size_ = 0;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -7,6 +7,8 @@
 
 #include <utility>
 
+using stage9::pstring;
+
 void test(bool verbose)
 {
     Framer framer{ "Monitoring", verbose };
@@ -0,0 +1,257 @@
+// vector.cpp                                                         -*-C++-*-
+#include <pstring_vector.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+void push_back_test(bool verbose);
+void append_test   (bool verbose);
+void sort_test     (bool verbose);
+void copy_test     (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    push_back_test(verbose);
+    append_test   (verbose);
+    sort_test     (verbose);
+    copy_test     (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void push_back_test(bool verbose)
+{
+    Framer framer{ "push_back", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    pstring_vector strings{ &tr };
+    ASSERT(strings.empty());
+    ASSERT((strings.begin() == strings.end()));
+
+    strings.push_back("IBM");
+    strings.push_back("");
+    strings.push_back("MSFT US Equity");
+
+    ASSERT_EQ(strings.size(), 3u);
+    ASSERT_EQ(strings[0], "IBM");
+    ASSERT_EQ(strings[1], "");
+    ASSERT_EQ(strings[2], "MSFT US Equity");
+    ASSERT_EQ(strings.chars_size(), 17u);
+
+    // The characters are contiguous, one string after the other.
+
+    ASSERT_EQ(strings[2].data(), strings[0].data() + 3);
+
+    // Two allocations, however many strings: one per buffer growth.
+
+    ASSERT_EQ(trm.delta_blocks_in_use(), 2);
+
+    char name[32];
+    for (int i = 0; i < 10000; ++i) {
+        std::snprintf(name, sizeof name, "symbol #%d", i);
+        strings.push_back(name);
+    }
+    ASSERT_EQ(strings[10002], "symbol #9999");
+    ASSERT((trm.delta_total_blocks() < 30));
+
+    // Adding an element of the object itself, while it grows, is fine.
+
+    for (int i = 0; i < 1000; ++i) {
+        strings.push_back(strings[i]);
+    }
+    ASSERT_EQ(strings[10003], "IBM");
+    ASSERT_EQ(strings[10005], "MSFT US Equity");
+}
+
+void append_test(bool verbose)
+{
+    Framer framer{ "bulk append", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    const std::vector<std::string> symbols{
+        "abc12", "IBM", "MSFT US Equity", "T 2 1/4 08/15/27", "EURUSD Curncy"
+    };
+
+    // Forward iterators: measure first, then allocate each buffer once.
+
+    pstring_vector strings{ &tr };
+    strings.append(symbols.begin(), symbols.end());
+    ASSERT_EQ(strings.size(), symbols.size());
+    ASSERT_EQ(trm.delta_total_blocks(), 2);
+
+    ASSERT(std::equal(strings.begin(), strings.end(), symbols.begin()));
+
+    // Input iterators: a single pass.
+
+    std::istringstream input{ "SPX Index GOOGL barfool" };
+    strings.append(std::istream_iterator<std::string>{ input },
+                   std::istream_iterator<std::string>{});
+    ASSERT_EQ(strings.size(), symbols.size() + 4);
+    ASSERT_EQ(strings[5], "SPX");
+    ASSERT_EQ(strings[8], "barfool");
+
+    // Iterators are random access.
+
+    pstring_vector::const_iterator it = strings.begin();
+    ASSERT_EQ(*(it + 2), "MSFT US Equity");
+    ASSERT_EQ(it[3], "T 2 1/4 08/15/27");
+    ASSERT_EQ(strings.end() - it, 9);
+    ASSERT((it < strings.end()));
+
+    // Appending the object to itself, while both buffers grow, is fine.
+
+    pstring_vector twice{ &tr };
+    char name[32];
+    for (int i = 0; i < 12; ++i) {
+        std::snprintf(name, sizeof name, "symbol #%d US Equity", i);
+        twice.push_back(name);
+    }
+    ASSERT_EQ(twice.size(), 12u);
+    const size_t chars = twice.chars_size();
+
+    twice.append(twice.begin(), twice.end());
+    ASSERT_EQ(twice.size(), 24u);
+    ASSERT_EQ(twice.chars_size(), 2 * chars);
+    ASSERT(std::equal(twice.begin(), twice.begin() + 12, twice.begin() + 12));
+    ASSERT_EQ(twice[23], "symbol #11 US Equity");
+
+    twice.append(twice.begin() + 20, twice.end());
+    ASSERT_EQ(twice.size(), 28u);
+    ASSERT_EQ(twice[24], "symbol #8 US Equity");
+
+    // So is appending views of its own strings.
+
+    const std::vector<std::string_view> views(twice.begin(), twice.end());
+    const size_t                        before = twice.chars_size();
+    twice.append(views.begin(), views.end());
+    ASSERT_EQ(twice.size(), 56u);
+    ASSERT_EQ(twice.chars_size(), 2 * before);
+    ASSERT(std::equal(twice.begin(), twice.begin() + 28, twice.begin() + 28));
+    ASSERT(!tr.has_errors());
+}
+
+void sort_test(bool verbose)
+{
+    Framer framer{ "sort and dedup", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    const char *words[] = {
+        "pear", "apple", "fig", "apple", "banana", "fig", "apple", "kiwi"
+    };
+
+    pstring_vector strings{ &tr };
+    strings.append(std::begin(words), std::end(words));
+    const char *chars = strings[0].data();
+    trm.reset();
+
+    strings.sort();
+    ASSERT_EQ(strings[0], "apple");
+    ASSERT_EQ(strings[3], "banana");
+    ASSERT_EQ(strings[7], "pear");
+    ASSERT(std::is_sorted(strings.begin(), strings.end()));
+
+    strings.dedup();
+    ASSERT_EQ(strings.size(), 5u);
+    ASSERT_EQ(strings[0], "apple");
+    ASSERT_EQ(strings[1], "banana");
+    ASSERT_EQ(strings[2], "fig");
+    ASSERT_EQ(strings[3], "kiwi");
+    ASSERT_EQ(strings[4], "pear");
+
+    // Only the offsets moved: the characters are where they were, and
+    // nothing was allocated.
+
+    ASSERT_EQ(strings[4].data(), chars);
+    ASSERT(trm.is_total_same());
+
+    strings.clear();
+    ASSERT(strings.empty());
+    ASSERT_EQ(strings.chars_size(), 0u);
+
+    // Empty strings have no characters to compare.
+
+    pstring_vector empties{ &tr };
+    empties.push_back("");
+    empties.push_back("");
+    empties.dedup();
+    ASSERT_EQ(empties.size(), 1u);
+}
+
+void copy_test(bool verbose)
+{
+    Framer framer{ "copy and move", verbose };
+
+    std::pmr::test_resource tr{ "object" };
+    tr.set_verbose(verbose);
+
+    std::pmr::test_resource          tr2{ "other" };
+    std::pmr::test_resource_monitor trm2{ tr2 };
+    tr2.set_verbose(verbose);
+
+    const char *words[] = { "fig", "apple", "fig", "kiwi", "apple" };
+
+    pstring_vector strings{ &tr };
+    strings.append(std::begin(words), std::end(words));
+    strings.sort();
+    strings.dedup();
+
+    // A copy keeps the characters of the remaining strings only.
+
+    pstring_vector copied{ strings, &tr2 };
+    ASSERT_EQ(copied.size(), 3u);
+    ASSERT_EQ(copied.chars_size(), 12u);
+    ASSERT(std::equal(copied.begin(), copied.end(), strings.begin()));
+    ASSERT_EQ(copied.get_allocator().resource(), &tr2);
+    ASSERT_EQ(trm2.delta_blocks_in_use(), 2);
+
+    pstring_vector moved{ std::move(copied) };
+    ASSERT(copied.empty());
+    ASSERT_EQ(moved[2], "kiwi");
+    ASSERT_EQ(moved.get_allocator().resource(), &tr2);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
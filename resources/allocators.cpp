@@ -0,0 +1,289 @@
+// allocators.cpp                                                     -*-C++-*-
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <bump_resource.h>
+#include <pstring_last.h>
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+void static_allocator_test  (bool verbose);
+void static_container_test  (bool verbose);
+void static_conversion_test (bool verbose);
+void at_least_test          (bool verbose);
+void try_resize_test        (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    static_allocator_test (verbose);
+    static_container_test (verbose);
+    static_conversion_test(verbose);
+    at_least_test         (verbose);
+    try_resize_test       (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+struct Point {
+    int m_x_;
+    int m_y_;
+
+    Point(int x, int y)
+    : m_x_(x)
+    , m_y_(y)
+    {
+    }
+};
+
+void static_allocator_test(bool verbose)
+{
+    Framer framer{ "static resource allocator", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    std::pmr::static_resource_allocator<std::pmr::test_resource> alloc{ &tr };
+    ASSERT_EQ(alloc.resource(), &tr);
+
+    void *bytes = alloc.allocate_bytes(100, 16);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    ASSERT_EQ(tr.bytes_in_use(), 100);
+    alloc.deallocate_bytes(bytes, 100, 16);
+
+    int *ints = alloc.allocate_object<int>(10);
+    ASSERT_EQ(tr.bytes_in_use(), 10 * static_cast<long long>(sizeof(int)));
+    alloc.deallocate_object(ints, 10);
+
+    Point *point = alloc.new_object<Point>(3, 4);
+    ASSERT_EQ(point->m_y_, 4);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    alloc.delete_object(point);
+
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT_EQ(trm.delta_total_blocks(), 3);
+
+    // Failures are reported exactly as through the virtual interface.
+
+    tr.set_allocation_limit(0);
+    bool thrown = false;
+    try {
+        (void)alloc.allocate_object<Point>();
+    }
+    catch (const std::pmr::test_resource_exception&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+    tr.set_allocation_limit(-1);
+}
+
+void static_container_test(bool verbose)
+{
+    Framer framer{ "static allocator in a container", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    using Alloc = std::pmr::static_resource_allocator<std::pmr::test_resource,
+                                                      int>;
+
+    {
+        std::vector<int, Alloc> ints{ Alloc{ &tr } };
+        for (int i = 0; i < 100; ++i) {
+            ints.push_back(i);
+        }
+        ASSERT_EQ(ints[99], 99);
+        ASSERT(trm.is_total_up());
+
+        std::vector<int, Alloc> copied{ ints };
+        ASSERT_EQ(copied.get_allocator().resource(), &tr);
+        ASSERT((copied.get_allocator() == ints.get_allocator()));
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    std::pmr::test_resource tr2{ "other" };
+    tr2.set_verbose(verbose);
+
+    Alloc mine{ &tr };
+    Alloc theirs{ &tr2 };
+    std::pmr::static_resource_allocator<std::pmr::test_resource> rebound{
+                                                                     mine };
+    ASSERT((mine != theirs));
+    ASSERT((rebound == mine));
+}
+
+void static_conversion_test(bool verbose)
+{
+    Framer framer{ "conversion to polymorphic allocator", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    std::pmr::static_resource_allocator<std::pmr::test_resource> alloc{ &tr };
+
+    // A type taking a polymorphic allocator gets the same resource.
+
+    pstring astring{ "barfool, but too long for the small buffer", alloc };
+    ASSERT_EQ(astring.get_allocator().resource(), &tr);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+}
+
+void at_least_test(bool verbose)
+{
+    Framer framer{ "allocate at least", verbose };
+
+    std::pmr::test_resource          tr{ "object" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    // 'test_resource' rounds up, and accounts for the rounded size.
+
+    std::pmr::polymorphic_allocator_P0339R5<> alloc{ &tr };
+    std::pmr::allocation_result<void *> result =
+                                          alloc.allocate_bytes_at_least(100);
+    ASSERT_EQ(result.count, 112u);
+    ASSERT_EQ(tr.bytes_in_use(), 112);
+
+    // The slack is usable, and deallocating with the actual size is not a
+    // mismatch.
+
+    static_cast<char *>(result.ptr)[111] = 'x';
+    alloc.deallocate_bytes(result.ptr, result.count);
+    ASSERT_EQ(tr.mismatches(), 0);
+    ASSERT_EQ(tr.bounds_errors(), 0);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    std::pmr::static_resource_allocator<std::pmr::test_resource> direct{ &tr };
+    result = direct.allocate_bytes_at_least(1, 1);
+    ASSERT_EQ(result.count, alignof(std::max_align_t));
+    direct.deallocate_bytes(result.ptr, result.count, 1);
+
+    // Sizes that would wrap around once rounded or padded are refused.
+
+    for (size_t bytes : { SIZE_MAX, SIZE_MAX - 100 }) {
+        bool thrown = false;
+        try {
+            (void)direct.allocate_bytes_at_least(bytes, 1);
+        }
+        catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        ASSERT(thrown);
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    // Other resources allocate exactly what was asked for.
+
+    std::pmr::polymorphic_allocator_P0339R5<> plain{
+                                            std::pmr::new_delete_resource() };
+    result = plain.allocate_bytes_at_least(100);
+    ASSERT_EQ(result.count, 100u);
+    plain.deallocate_bytes(result.ptr, result.count);
+}
+
+void try_resize_test(bool verbose)
+{
+    Framer framer{ "try resize", verbose };
+
+    // Standard resources resize nothing, except to the same size.
+
+    std::pmr::polymorphic_allocator_P0339R5<> plain{
+                                            std::pmr::new_delete_resource() };
+    void *block = plain.allocate_bytes(100);
+    ASSERT(!plain.try_resize_bytes(block, 100, 200));
+    ASSERT(plain.try_resize_bytes(block, 100, 100));
+    plain.deallocate_bytes(block, 100);
+
+    // 'test_resource' resizes a block when its upstream resource does, and
+    // moves the guard band along.
+
+    bump_resource                    bump{ 4096 };
+    std::pmr::test_resource          tr{ "object", &bump };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+    tr.set_no_abort(true);
+
+    std::pmr::static_resource_allocator<std::pmr::test_resource> alloc{ &tr };
+    char *chars = static_cast<char *>(alloc.allocate_bytes(100));
+    ASSERT(alloc.try_resize_bytes(chars, 100, 1000));
+    ASSERT_EQ(tr.bytes_in_use(), 1000);
+    ASSERT_EQ(tr.max_bytes(), 1000);
+    ASSERT_EQ(tr.total_bytes(), 1000);
+    chars[999] = 'x';
+
+    ASSERT(alloc.try_resize_bytes(chars, 1000, 10));
+    ASSERT_EQ(tr.bytes_in_use(), 10);
+    ASSERT_EQ(tr.max_bytes(), 1000);
+
+    // Writing past the new end is an overrun, and the old size a mismatch.
+
+    chars[10] = 'x';
+    tr.set_quiet(true);
+    ASSERT(!alloc.try_resize_bytes(chars, 10, 20));
+    ASSERT_EQ(tr.bounds_errors(), 1);
+    chars[10] = static_cast<char>(0xB1);
+    ASSERT(!alloc.try_resize_bytes(chars, 100, 20));
+    ASSERT_EQ(tr.bad_deallocate_params(), 1);
+    tr.set_quiet(false);
+
+    // Once another block follows it, the upstream block is fixed.
+
+    void *other = alloc.allocate_bytes(16);
+    ASSERT(!alloc.try_resize_bytes(chars, 10, 20));
+    ASSERT_EQ(tr.bytes_in_use(), 26);
+
+    alloc.deallocate_bytes(other, 16);
+    alloc.deallocate_bytes(chars, 10);
+    ASSERT_EQ(tr.mismatches(), 0);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    // Capturing call stacks and analyzing growth keep the block last
+    // upstream.
+
+    bump_resource           traced{ 4096 };
+    std::pmr::test_resource ttr{ "traced", &traced };
+    ttr.set_verbose(verbose);
+    ttr.set_capture_stacks(true);
+    ttr.set_track_growth(true);
+
+    std::pmr::static_resource_allocator<std::pmr::test_resource> talloc{
+                                                                      &ttr };
+    char *traced_chars = static_cast<char *>(talloc.allocate_bytes(100));
+    ASSERT(talloc.try_resize_bytes(traced_chars, 100, 1000));
+    ASSERT_EQ(ttr.bytes_in_use(), 1000);
+    talloc.deallocate_bytes(traced_chars, 1000);
+    ASSERT_EQ(ttr.blocks_in_use(), 0);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,182 @@
+// bump.cpp                                                           -*-C++-*-
+#include <bump_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <pstring_last.h>
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+void allocate_test(bool verbose);
+void resize_test  (bool verbose);
+void pstring_test (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    allocate_test(verbose);
+    resize_test  (verbose);
+    pstring_test (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void allocate_test(bool verbose)
+{
+    Framer framer{ "allocate", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    {
+        bump_resource bump{ 256, &tr };
+        ASSERT_EQ(bump.upstream_resource(), &tr);
+        ASSERT(trm.is_total_same());
+
+        char *a = static_cast<char *>(bump.allocate(10, 1));
+        char *b = static_cast<char *>(bump.allocate(8, 8));
+        ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+        ASSERT_EQ(b, a + 16);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(b) % 8, 0u);
+
+        // Only the last block gives its bytes back.
+
+        bump.deallocate(a, 10, 1);
+        ASSERT_EQ(bump.allocate(8, 8), static_cast<void *>(a + 24));
+        bump.deallocate(a + 24, 8, 8);
+        bump.deallocate(b, 8, 8);
+        ASSERT_EQ(bump.allocate(8, 8), static_cast<void *>(b));
+
+        // A block that does not fit starts a new, bigger, chunk.
+
+        (void)bump.allocate(1000, 16);
+        ASSERT_EQ(trm.delta_blocks_in_use(), 2);
+
+        bump.release();
+        ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+        (void)bump.allocate(1, 1);
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    // A block that fits only before its alignment is applied, and one that
+    // fits nowhere.
+
+    {
+        bump_resource bump{ 1000, &tr };
+        (void)bump.allocate(983, 1);
+        char *c = static_cast<char *>(bump.allocate(8, 16));
+        ASSERT_EQ(trm.delta_blocks_in_use(), 2);
+        std::memset(c, 'c', 8);
+
+        for (size_t bytes : { SIZE_MAX, SIZE_MAX - 8 }) {
+            bool thrown = false;
+            try {
+                (void)bump.allocate(bytes, 16);
+            }
+            catch (const std::bad_alloc&) {
+                thrown = true;
+            }
+            ASSERT(thrown);
+        }
+        ASSERT_EQ(trm.delta_blocks_in_use(), 2);
+    }
+    ASSERT(!tr.has_errors());
+}
+
+void resize_test(bool verbose)
+{
+    Framer framer{ "resize in place", verbose };
+
+    std::pmr::test_resource tr{ "upstream" };
+    tr.set_verbose(verbose);
+
+    bump_resource bump{ 1024, &tr };
+
+    char *a = static_cast<char *>(bump.allocate(100, 1));
+    a[99] = 'a';
+
+    ASSERT(bump.try_resize(a, 100, 500, 1));
+    a[499] = 'a';
+    ASSERT(bump.try_resize(a, 500, 50, 1));
+
+    // Once another block follows it, a block is fixed.
+
+    char *b = static_cast<char *>(bump.allocate(10, 1));
+    ASSERT_EQ(b, a + 50);
+    ASSERT(!bump.try_resize(a, 50, 60, 1));
+
+    // The last block can grow only to the end of its chunk.
+
+    ASSERT(!bump.try_resize(b, 10, 2000, 1));
+    ASSERT(std::pmr::try_resize(&bump, b, 10, 900, 1));
+    ASSERT_EQ(tr.total_blocks(), 1);
+}
+
+void pstring_test(bool verbose)
+{
+    Framer framer{ "pstring growth", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    bump_resource bump{ 64 * 1024, &tr };
+
+    // A string growing at the end of the arena is resized in place: its
+    // characters never move.
+
+    pstring built{ "", &bump };
+    built.append(std::string(100, 'x').c_str(), 100);
+    const char *chars = built.data();
+    for (int i = 0; i < 10000; ++i) {
+        built += 'y';
+    }
+    ASSERT_EQ(built.data(), chars);
+    ASSERT_EQ(built.size(), 10100u);
+    ASSERT_EQ(built.str(), std::string(100, 'x') + std::string(10000, 'y'));
+
+    built.reserve(20000);
+    ASSERT_EQ(built.data(), chars);
+    ASSERT_EQ(trm.delta_total_blocks(), 1);
+
+    // Another allocation pins it, and it moves again.
+
+    pstring other{ "a string too long for the small buffer", &bump };
+    built.reserve(30000);
+    ASSERT((built.data() != chars));
+    ASSERT_EQ(built.size(), 10100u);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
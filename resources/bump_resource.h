@@ -0,0 +1,176 @@
+// bump_resource.h                                                    -*-C++-*-
+#ifndef BUMP_RESOURCE_H_INCLUDED
+#define BUMP_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+class bump_resource final : public std::pmr::extended_memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // A monotonic resource: blocks are carved in order from chunks allocated
+    // from an upstream resource, each chunk twice the size of the previous
+    // one, and are all freed at once by 'release' or the destructor.  The
+    // most recently allocated block is the exception: deallocating it gives
+    // its bytes back, and it can be resized in place as far as its chunk
+    // allows, so a buffer growing at the end of the arena costs no copies.
+
+    template <class, class>
+        friend class std::pmr::static_resource_allocator;
+
+    struct chunk {
+        chunk  *m_next_;  // the previously allocated chunk
+        size_t  m_size_;  // size of this chunk, header included
+    };
+
+    std::pmr::memory_resource *m_upstream_;
+    chunk                     *m_chunks_{ nullptr };  // most recent first
+    char                      *m_next_{ nullptr };    // first free byte
+    char                      *m_end_{ nullptr };     // end of the chunk
+    size_t                     m_next_size_;          // of the next chunk
+
+public:
+    explicit bump_resource(
+              size_t                     initial_size = 1024,
+              std::pmr::memory_resource *upstream =
+                                           std::pmr::get_default_resource())
+        // Create a resource allocating its first chunk, of the specified
+        // 'initial_size', from the specified 'upstream' resource, on first
+        // use.
+    : m_upstream_(upstream)
+    , m_next_size_(std::max(initial_size, 2 * sizeof(chunk)))
+    {
+    }
+
+    bump_resource(const bump_resource&) = delete;
+    bump_resource& operator=(const bump_resource&) = delete;
+
+    ~bump_resource()
+    {
+        release();
+    }
+
+    void release();
+        // Free all the chunks, and so all the blocks allocated from this
+        // object.
+
+    std::pmr::memory_resource *upstream_resource() const
+    {
+        return m_upstream_;
+    }
+
+private:
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+
+    bool do_try_resize(void   *p,
+                       size_t  old_size,
+                       size_t  new_size,
+                       size_t  alignment) override;
+        // Resize the block at the specified 'p' and return 'true' if it is
+        // the most recently allocated block and the new size fits in its
+        // chunk; otherwise return 'false'.
+};
+
+inline
+void bump_resource::release()
+{
+    while (m_chunks_) {
+        chunk *next = m_chunks_->m_next_;
+        m_upstream_->deallocate(m_chunks_,
+                                m_chunks_->m_size_,
+                                alignof(std::max_align_t));
+        m_chunks_ = next;
+    }
+    m_next_ = nullptr;
+    m_end_  = nullptr;
+}
+
+inline
+void *bump_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    auto aligned = [alignment](char *p) {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((alignment - address % alignment) % alignment);
+    };
+
+    // Aligning may move the block past the end of the chunk, where the
+    // room left would be negative.
+
+    char *result = m_next_ ? aligned(m_next_) : nullptr;
+    if (!result ||
+        result > m_end_ ||
+        static_cast<size_t>(m_end_ - result) < bytes) {
+        // Start a new chunk, big enough for the block at any alignment.
+
+        if (bytes > SIZE_MAX - sizeof(chunk) - alignment) {
+            throw std::bad_alloc();
+        }
+
+        const size_t size = std::max(m_next_size_,
+                                     sizeof(chunk) + bytes + alignment);
+        chunk *fresh = static_cast<chunk *>(
+                  m_upstream_->allocate(size, alignof(std::max_align_t)));
+        fresh->m_next_ = m_chunks_;
+        fresh->m_size_ = size;
+        m_chunks_      = fresh;
+        m_next_size_   = 2 * size;
+
+        m_end_ = reinterpret_cast<char *>(fresh) + size;
+        result = aligned(reinterpret_cast<char *>(fresh + 1));
+    }
+
+    m_next_ = result + bytes;
+    return result;
+}
+
+inline
+void bump_resource::do_deallocate(void *p, size_t bytes, size_t)
+{
+    if (static_cast<char *>(p) + bytes == m_next_) {
+        m_next_ = static_cast<char *>(p);
+    }
+}
+
+inline
+bool bump_resource::do_try_resize(void   *p,
+                                  size_t  old_size,
+                                  size_t  new_size,
+                                  size_t)
+{
+    char *block = static_cast<char *>(p);
+    if (block + old_size != m_next_ ||
+        static_cast<size_t>(m_end_ - block) < new_size) {
+        return false;                                                 // RETURN
+    }
+
+    m_next_ = block + new_size;
+    return true;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,236 @@
+// concurrent_monotonic.cpp                                           -*-C++-*-
+#include <concurrent_monotonic_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+
+void bump_test     (bool verbose);
+void release_test  (bool verbose);
+void thread_test   (bool verbose);
+void switch_test   (bool verbose);
+void upstream_test (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    bump_test     (verbose);
+    release_test  (verbose);
+    thread_test   (verbose);
+    switch_test   (verbose);
+    upstream_test (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void bump_test(bool verbose)
+{
+    Framer framer{ "bump", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    concurrent_monotonic_resource resource{ 1024, &tr };
+    ASSERT_EQ(resource.upstream_resource(), &tr);
+    ASSERT_EQ(resource.chunk_count(), 0u);
+
+    char *a = static_cast<char *>(resource.allocate(10, 1));
+    char *b = static_cast<char *>(resource.allocate(8, 8));
+    ASSERT_EQ(b, a + 16);
+    ASSERT_EQ(resource.chunk_count(), 1u);
+    ASSERT_EQ(tr.last_allocated_num_bytes(), 1024);
+
+    // Deallocation does nothing.
+
+    resource.deallocate(b, 8, 8);
+    ASSERT_EQ(resource.allocate(8, 8), static_cast<void *>(b + 8));
+
+    void *aligned = resource.allocate(16, 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0u);
+
+    // The next chunks double, and a large block gets a chunk of its own.
+
+    (void)resource.allocate(1000, 8);
+    ASSERT_EQ(resource.chunk_count(), 2u);
+    ASSERT_EQ(tr.last_allocated_num_bytes(), 2048);
+
+    (void)resource.allocate(5000, 8);
+    ASSERT_EQ(resource.chunk_count(), 3u);
+
+    (void)resource.allocate(8, 8);
+    ASSERT_EQ(resource.chunk_count(), 3u);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 3);
+
+    // Sizes that would wrap around with the header and the alignment added
+    // are refused.
+
+    for (size_t bytes : { SIZE_MAX, SIZE_MAX - 16 }) {
+        bool thrown = false;
+        try {
+            (void)resource.allocate(bytes, 8);
+        }
+        catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        ASSERT(thrown);
+    }
+    ASSERT_EQ(resource.chunk_count(), 3u);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 3);
+}
+
+void release_test(bool verbose)
+{
+    Framer framer{ "release", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    {
+        concurrent_monotonic_resource resource{ 256, &tr };
+        for (int i = 0; i < 100; ++i) {
+            (void)resource.allocate(100, 8);
+        }
+        ASSERT_EQ(trm.delta_blocks_in_use(),
+                  static_cast<long long>(resource.chunk_count()));
+
+        resource.release();
+        ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+        ASSERT_EQ(resource.chunk_count(), 0u);
+
+        // The thread forgot its chunk, and claims a new one.
+
+        (void)resource.allocate(100, 8);
+        ASSERT_EQ(resource.chunk_count(), 1u);
+        ASSERT_EQ(tr.last_allocated_num_bytes(), 256);
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+}
+
+void thread_test(bool verbose)
+{
+    Framer framer{ "threads", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+
+    constexpr int threadCount = 4;
+    constexpr int blockCount  = 10000;
+
+    concurrent_monotonic_resource resource{ &tr };
+
+    // Each thread fills its blocks with its own number: no block may be
+    // overwritten by another thread.
+
+    std::vector<std::vector<unsigned char *>> blocks(threadCount);
+    std::vector<std::thread>                  threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&resource, &blocks, t]() {
+            for (int i = 0; i < blockCount; ++i) {
+                const size_t size = 1 + i % 50;
+                auto *block = static_cast<unsigned char *>(
+                                                resource.allocate(size, 1));
+                std::fill(block, block + size, static_cast<unsigned char>(t));
+                blocks[t].push_back(block);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int overwritten = 0;
+    for (int t = 0; t < threadCount; ++t) {
+        for (int i = 0; i < blockCount; ++i) {
+            const unsigned char *block = blocks[t][i];
+            for (size_t j = 0; j < 1 + i % 50u; ++j) {
+                overwritten += block[j] != t;
+            }
+        }
+    }
+    ASSERT_EQ(overwritten, 0);
+    ASSERT_EQ(trm.delta_blocks_in_use(),
+              static_cast<long long>(resource.chunk_count()));
+
+    resource.release();
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+}
+
+void switch_test(bool verbose)
+{
+    Framer framer{ "several resources", verbose };
+
+    // A thread keeps its chunk in each of the resources it uses.
+
+    concurrent_monotonic_resource first;
+    concurrent_monotonic_resource second;
+    for (int i = 0; i < 100; ++i) {
+        (void)first.allocate(8, 8);
+        (void)second.allocate(8, 8);
+    }
+    ASSERT_EQ(first.chunk_count(), 1u);
+    ASSERT_EQ(second.chunk_count(), 1u);
+}
+
+void upstream_test(bool verbose)
+{
+    Framer framer{ "upstream of test_resource", verbose };
+
+    constexpr int threadCount = 4;
+
+    concurrent_monotonic_resource resource;
+
+    std::pmr::test_resource tr{ "checked", &resource };
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&tr]() {
+                std::pmr::vector<std::pmr::vector<int>> lists{ &tr };
+                for (int i = 0; i < 1000; ++i) {
+                    lists.emplace_back(i % 10, i);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    ASSERT_EQ(tr.blocks_in_use(), 0);
+    ASSERT_EQ(tr.total_blocks(), threadCount * (900 + 11));
+    ASSERT(!tr.has_errors());
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
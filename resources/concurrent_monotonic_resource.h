@@ -0,0 +1,228 @@
+// concurrent_monotonic_resource.h                                    -*-C++-*-
+#ifndef CONCURRENT_MONOTONIC_RESOURCE_H_INCLUDED
+#define CONCURRENT_MONOTONIC_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+class concurrent_monotonic_resource final
+                                         : public std::pmr::memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // A monotonic resource that several threads may allocate from at once.
+    // Each thread bumps a pointer within a chunk of its own, without any
+    // synchronization, and claims a new chunk from the upstream resource,
+    // which must be thread safe, when its chunk is exhausted.  The chunks
+    // of a thread double in size, up to 64 times the initial size; a block
+    // too large for the next chunk gets a chunk of its own.  All the chunks
+    // are pushed on a shared list with a compare-and-swap, and deallocated
+    // at once by 'release' or the destructor; 'deallocate' does nothing.
+    //
+    // A thread remembers its chunks in the four resources it used most
+    // recently; in other resources it starts a new chunk.
+
+    struct alignas(std::max_align_t) chunk {
+        chunk  *m_next_;        // previously claimed chunk
+        size_t  m_size_;        // including this header
+    };
+
+    struct thread_chunk {
+        // The current chunk of a thread in a resource.
+
+        unsigned long long  m_serial_;      // of the resource, 0 if unused
+        char               *m_next_;        // first free byte
+        char               *m_end_;
+        size_t              m_next_size_;   // of the next chunk
+    };
+
+    static constexpr int thread_chunk_count = 4;
+
+    static inline std::atomic<unsigned long long> s_next_serial_{ 1 };
+
+    static inline thread_local thread_chunk s_chunks_[thread_chunk_count];
+    static inline thread_local unsigned     s_victim_;
+        // the next entry of 's_chunks_' to reuse
+
+    std::pmr::memory_resource *m_upstream_;
+    size_t                     m_initial_size_;
+    unsigned long long         m_serial_;   // renewed by 'release'
+    std::atomic<chunk *>       m_chunks_{ nullptr };
+    std::atomic<size_t>        m_chunk_count_{ 0 };
+
+public:
+    explicit concurrent_monotonic_resource(
+              size_t                     initial_size = 4096,
+              std::pmr::memory_resource *upstream =
+                                           std::pmr::get_default_resource())
+        // Create a resource claiming chunks of at least the specified
+        // 'initial_size' bytes from the specified 'upstream' resource.
+    : m_upstream_(upstream)
+    , m_initial_size_(std::max(initial_size, 2 * sizeof(chunk)))
+    , m_serial_(s_next_serial_.fetch_add(1, std::memory_order_relaxed))
+    {
+    }
+
+    explicit concurrent_monotonic_resource(
+                                         std::pmr::memory_resource *upstream)
+    : concurrent_monotonic_resource(4096, upstream)
+    {
+    }
+
+    concurrent_monotonic_resource(
+                               const concurrent_monotonic_resource&) = delete;
+    concurrent_monotonic_resource& operator=(
+                               const concurrent_monotonic_resource&) = delete;
+
+    ~concurrent_monotonic_resource()
+    {
+        release();
+    }
+
+    void release();
+        // Deallocate all the chunks.  The behavior is undefined if another
+        // thread uses the resource meanwhile.
+
+    size_t chunk_count() const
+        // Return the number of chunks claimed from upstream.
+    {
+        return m_chunk_count_.load(std::memory_order_relaxed);
+    }
+
+    std::pmr::memory_resource *upstream_resource() const
+    {
+        return m_upstream_;
+    }
+
+private:
+    thread_chunk *current();
+        // Return the current chunk of the calling thread in this resource,
+        // empty if it has none.
+
+    chunk *claim(size_t size);
+        // Allocate a chunk of the specified 'size' from upstream and push it
+        // on the list of chunks.
+
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *, size_t, size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+};
+
+inline
+void concurrent_monotonic_resource::release()
+{
+    chunk *each = m_chunks_.exchange(nullptr, std::memory_order_acquire);
+    while (each) {
+        chunk *next = each->m_next_;
+        m_upstream_->deallocate(each, each->m_size_, alignof(chunk));
+        each = next;
+    }
+    m_chunk_count_.store(0, std::memory_order_relaxed);
+
+    // The threads forget their chunks, now gone, as the serial changes.
+
+    m_serial_ = s_next_serial_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline
+concurrent_monotonic_resource::thread_chunk *
+concurrent_monotonic_resource::current()
+{
+    for (thread_chunk& each : s_chunks_) {
+        if (each.m_serial_ == m_serial_) {
+            return &each;                                             // RETURN
+        }
+    }
+
+    thread_chunk *result = s_chunks_ + s_victim_++ % thread_chunk_count;
+    *result = { m_serial_, nullptr, nullptr, m_initial_size_ };
+    return result;
+}
+
+inline
+concurrent_monotonic_resource::chunk *
+concurrent_monotonic_resource::claim(size_t size)
+{
+    chunk *fresh = static_cast<chunk *>(m_upstream_->allocate(size,
+                                                              alignof(chunk)));
+    fresh->m_size_ = size;
+    fresh->m_next_ = m_chunks_.load(std::memory_order_relaxed);
+    while (!m_chunks_.compare_exchange_weak(fresh->m_next_,
+                                            fresh,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+    m_chunk_count_.fetch_add(1, std::memory_order_relaxed);
+    return fresh;
+}
+
+inline
+void *concurrent_monotonic_resource::do_allocate(size_t bytes,
+                                                 size_t alignment)
+{
+    thread_chunk *mine = current();
+
+    auto align = [alignment](char *p) {
+        return reinterpret_cast<char *>(
+                (reinterpret_cast<std::uintptr_t>(p) + alignment - 1) /
+                                                    alignment * alignment);
+    };
+
+    if (mine->m_next_) {
+        char *result = align(mine->m_next_);
+        if (result <= mine->m_end_ &&
+            bytes <= static_cast<size_t>(mine->m_end_ - result)) {
+            mine->m_next_ = result + bytes;
+            return result;                                            // RETURN
+        }
+    }
+
+    // Claim a chunk; the slack covers the header and the alignment.
+
+    if (bytes > SIZE_MAX - sizeof(chunk) - alignment) {
+        throw std::bad_alloc();
+    }
+
+    const size_t needed = sizeof(chunk) + bytes + alignment;
+    if (needed > mine->m_next_size_) {
+        chunk *own = claim(needed);
+        return align(reinterpret_cast<char *>(own + 1));              // RETURN
+    }
+
+    const size_t size  = mine->m_next_size_;
+    chunk       *fresh = claim(size);
+    mine->m_next_size_ = std::min(2 * size, 64 * m_initial_size_);
+
+    char *result  = align(reinterpret_cast<char *>(fresh + 1));
+    mine->m_next_ = result + bytes;
+    mine->m_end_  = reinterpret_cast<char *>(fresh) + size;
+    return result;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,217 @@
+// huge_page.cpp                                                      -*-C++-*-
+#include <huge_page_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <cstdint>
+#include <cstring>
+
+using page_kind = huge_page_resource::page_kind;
+
+void size_class_test(bool verbose);
+void large_test     (bool verbose);
+void kind_test      (bool verbose);
+void upstream_test  (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    size_class_test(verbose);
+    large_test     (verbose);
+    kind_test      (verbose);
+    upstream_test  (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+size_t totalMapped(const huge_page_resource& resource)
+{
+    return resource.mapped_bytes(page_kind::huge) +
+           resource.mapped_bytes(page_kind::transparent) +
+           resource.mapped_bytes(page_kind::normal);
+}
+
+bool isAligned(const void *p, size_t alignment)
+{
+    return 0 == reinterpret_cast<std::uintptr_t>(p) % alignment;
+}
+
+void size_class_test(bool verbose)
+{
+    Framer framer{ "size classes", verbose };
+
+    huge_page_resource resource;
+    ASSERT_EQ(totalMapped(resource), 0u);
+
+    // Small blocks come from one region, one after the other, maximally
+    // aligned or at their alignment.
+
+    char *a = static_cast<char *>(resource.allocate(10, 1));
+    char *b = static_cast<char *>(resource.allocate(100, 8));
+    char *c = static_cast<char *>(resource.allocate(4000, 4096));
+    ASSERT_EQ(totalMapped(resource), huge_page_resource::region_size);
+    ASSERT(isAligned(a, alignof(std::max_align_t)));
+    ASSERT_EQ(b, a + 16);
+    ASSERT(isAligned(c, 4096));
+    std::memset(c, 'c', 4000);
+
+    // A freed block is reused by a block of the same class.
+
+    resource.deallocate(b, 100, 8);
+    ASSERT_EQ(resource.allocate(128, 16), static_cast<void *>(b));
+    resource.deallocate(a, 10, 1);
+    ASSERT_EQ(resource.allocate(1, 1), static_cast<void *>(a));
+
+    // A freed block is not reused by a block aligned more than it is.
+
+    (void)resource.allocate(16, 8);
+    char *d = static_cast<char *>(resource.allocate(4096, 8));
+    ASSERT_EQ(d, c + 4096 + 16);
+    resource.deallocate(d, 4096, 8);
+    void *e = resource.allocate(4096, 4096);
+    ASSERT((e != d));
+    ASSERT(isAligned(e, 4096));
+    ASSERT_EQ(resource.allocate(4096, 8), static_cast<void *>(d));
+
+    // Two blocks of the largest class fill a region; more need another.
+
+    huge_page_resource halves;
+    void *first  = halves.allocate(1 << 20, 8);
+    void *second = halves.allocate(1 << 20, 8);
+    ASSERT_EQ(static_cast<char *>(second), static_cast<char *>(first) +
+                                                                  (1 << 20));
+    ASSERT_EQ(totalMapped(halves), huge_page_resource::region_size);
+    (void)halves.allocate(1 << 20, 8);
+    ASSERT_EQ(totalMapped(halves), 2 * huge_page_resource::region_size);
+}
+
+void large_test(bool verbose)
+{
+    Framer framer{ "large blocks", verbose };
+
+    huge_page_resource resource;
+
+    // Large blocks are mapped on their own, in whole regions.
+
+    char *large = static_cast<char *>(resource.allocate(3 << 20, 64));
+    ASSERT(isAligned(large, huge_page_resource::region_size));
+    ASSERT_EQ(totalMapped(resource), 2 * huge_page_resource::region_size);
+    large[0]             = 'a';
+    large[(3 << 20) - 1] = 'z';
+    resource.deallocate(large, 3 << 20, 64);
+
+    char *again = static_cast<char *>(resource.allocate((1 << 20) + 1, 8));
+    ASSERT_EQ(totalMapped(resource), 3 * huge_page_resource::region_size);
+    again[1 << 20] = 'x';
+    resource.deallocate(again, (1 << 20) + 1, 8);
+
+    bool thrown = false;
+    try {
+        (void)resource.allocate(64, 2 * huge_page_resource::region_size);
+    }
+    catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+
+    // Sizes past the largest size class, or too large to round up to whole
+    // regions, are refused.
+
+    const size_t mapped = totalMapped(resource);
+    for (size_t bytes : { SIZE_MAX,
+                          SIZE_MAX - huge_page_resource::region_size,
+                          SIZE_MAX / 2 + 2 }) {
+        thrown = false;
+        try {
+            (void)resource.allocate(bytes, 8);
+        }
+        catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        ASSERT(thrown);
+    }
+    ASSERT_EQ(totalMapped(resource), mapped);
+}
+
+void kind_test(bool verbose)
+{
+    Framer framer{ "page kinds", verbose };
+
+    // Explicit huge pages are used only if the system has them reserved.
+
+    huge_page_resource preferred;
+    (void)preferred.allocate(64, 8);
+    ASSERT_EQ(totalMapped(preferred), huge_page_resource::region_size);
+    ASSERT_EQ(preferred.mapped_bytes(preferred.kind()),
+              huge_page_resource::region_size);
+
+    huge_page_resource normal{ page_kind::normal };
+    (void)normal.allocate(64, 8);
+    ASSERT((normal.kind() == page_kind::normal));
+    ASSERT_EQ(normal.mapped_bytes(page_kind::normal),
+              huge_page_resource::region_size);
+
+    huge_page_resource transparent{ page_kind::transparent };
+    (void)transparent.allocate(64, 8);
+    ASSERT((transparent.kind() != page_kind::huge));
+}
+
+void upstream_test(bool verbose)
+{
+    Framer framer{ "upstream", verbose };
+
+    huge_page_resource resource;
+
+    std::pmr::test_resource tr{ "huge pages", &resource };
+    tr.set_verbose(verbose);
+
+    {
+        std::pmr::vector<long> values{ &tr };
+        for (long i = 0; i < 1000000; ++i) {
+            values.push_back(i);
+        }
+        ASSERT_EQ(values[999999], 999999);
+    }
+    ASSERT_EQ(tr.blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+
+    // The pool resources ask for over-aligned chunks, which 'test_resource'
+    // does not support, but this resource does.
+
+    std::pmr::synchronized_pool_resource pool{ &resource };
+    std::pmr::vector<std::pmr::vector<long>> lists{ &pool };
+    for (long i = 0; i < 1000; ++i) {
+        lists.emplace_back(i % 100, i);
+    }
+    ASSERT_EQ(lists[999].size(), 99u);
+    ASSERT_EQ(lists[999][98], 999);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
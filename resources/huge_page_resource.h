@@ -0,0 +1,280 @@
+// huge_page_resource.h                                               -*-C++-*-
+#ifndef HUGE_PAGE_RESOURCE_H_INCLUDED
+#define HUGE_PAGE_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include <sys/mman.h>
+
+class huge_page_resource final : public std::pmr::memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // Serve allocations from memory mapped in 2 MiB regions, so that they are
+    // backed by huge pages, which each take a single TLB entry.  A region is
+    // mapped with 'MAP_HUGETLB' if the system has huge pages reserved,
+    // otherwise with normal pages advised with 'MADV_HUGEPAGE', so that
+    // transparent huge pages back it if enabled, otherwise with normal pages
+    // only.  Blocks of up to 1 MiB are rounded up to a power of two, carved
+    // in turn from shared regions, maximally aligned or at their requested
+    // alignment if larger, and recycled by size class; the regions hold no
+    // header, so that two 1 MiB blocks fill one.  Larger blocks get a
+    // mapping of their own, rounded up to whole regions, and are unmapped
+    // when deallocated.  Small blocks are only given back to the system by
+    // the destructor, and large blocks not deallocated by then are leaked.
+    //
+    // The resource is not synchronized, and may be the upstream of a
+    // 'synchronized_pool_resource', which is.  Requires Linux.
+
+public:
+    enum class page_kind {
+        huge,           // explicit huge pages, 'MAP_HUGETLB'
+        transparent,    // normal pages advised with 'MADV_HUGEPAGE'
+        normal          // normal pages
+    };
+
+    static constexpr size_t region_size = size_t(2) << 20;
+
+private:
+    static constexpr size_t smallest_class = 16;
+    static constexpr int    class_count    = 17;  // 16 bytes to 1 MiB
+
+    struct free_block {
+        free_block *m_next_;
+    };
+
+    page_kind   m_preferred_;
+    bool        m_hugetlb_;                    // huge pages may be reserved
+    page_kind   m_kind_{ page_kind::normal };  // of the last mapping
+    size_t      m_mapped_[3]{};                // bytes mapped of each kind
+    std::vector<void *>
+                m_regions_;                    // shared regions, unmapped
+                                               // by the destructor
+    char       *m_next_{ nullptr };            // first free byte of a region
+    char       *m_end_{ nullptr };             // end of that region
+    free_block *m_free_[class_count]{};
+
+public:
+    explicit huge_page_resource(page_kind preferred = page_kind::huge)
+        // Create a resource mapping the specified 'preferred' kind of pages,
+        // or, if the system cannot provide them, the next kind down.
+    : m_preferred_(preferred)
+    , m_hugetlb_(page_kind::huge == preferred)
+    {
+    }
+
+    huge_page_resource(const huge_page_resource&) = delete;
+    huge_page_resource& operator=(const huge_page_resource&) = delete;
+
+    ~huge_page_resource();
+
+    page_kind kind() const
+        // Return the kind of pages of the last mapping.
+    {
+        return m_kind_;
+    }
+
+    size_t mapped_bytes(page_kind kind) const
+        // Return the number of bytes ever mapped with pages of the
+        // specified 'kind'.
+    {
+        return m_mapped_[static_cast<int>(kind)];
+    }
+
+private:
+    static int size_class(size_t bytes, size_t alignment)
+        // Return the size class of the blocks of the specified 'bytes' and
+        // 'alignment', or -1 if they are mapped on their own.
+    {
+        const size_t size = std::max(bytes, alignment);
+        if (size > (smallest_class << (class_count - 1))) {
+            return -1;                                                // RETURN
+        }
+
+        int index = 0;
+        for (size_t each = smallest_class; each < size; each *= 2) {
+            ++index;
+        }
+        return index;
+    }
+
+    static size_t region_bytes(size_t bytes)
+        // Return the specified 'bytes' rounded up to whole regions.  Throw
+        // 'std::bad_alloc' if they, and the extra region 'map' trims, do not
+        // fit in a 'size_t'.
+    {
+        if (bytes > SIZE_MAX - 2 * region_size) {
+            throw std::bad_alloc();
+        }
+        return (bytes + region_size - 1) / region_size * region_size;
+    }
+
+    void *map(size_t bytes);
+        // Return a mapping of the specified 'bytes', a multiple of
+        // 'region_size', aligned to 'region_size'.  Throw 'std::bad_alloc'
+        // on failure.
+
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+};
+
+inline
+huge_page_resource::~huge_page_resource()
+{
+    for (void *each : m_regions_) {
+        ::munmap(each, region_size);
+    }
+}
+
+inline
+void *huge_page_resource::map(size_t bytes)
+{
+#ifdef MAP_HUGETLB
+    if (m_hugetlb_) {
+        void *result = ::mmap(nullptr,
+                              bytes,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                              -1,
+                              0);
+        if (MAP_FAILED != result) {
+            m_kind_ = page_kind::huge;
+            m_mapped_[static_cast<int>(m_kind_)] += bytes;
+            return result;                                            // RETURN
+        }
+
+        // No huge pages are reserved: do not ask again.
+
+        m_hugetlb_ = false;
+    }
+#endif
+
+    // Map a region more, and trim the mapping to the alignment of regions,
+    // as only aligned regions can be backed by transparent huge pages.
+
+    void *raw = ::mmap(nullptr,
+                       bytes + region_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1,
+                       0);
+    if (MAP_FAILED == raw) {
+        throw std::bad_alloc();
+    }
+
+    char *first   = static_cast<char *>(raw);
+    char *aligned = reinterpret_cast<char *>(
+           (reinterpret_cast<std::uintptr_t>(first) + region_size - 1) /
+                                                   region_size * region_size);
+    if (aligned != first) {
+        ::munmap(first, aligned - first);
+    }
+    ::munmap(aligned + bytes, first + region_size - aligned);
+
+    m_kind_ = page_kind::normal;
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    if (page_kind::normal == m_preferred_) {
+        (void)::madvise(aligned, bytes, MADV_NOHUGEPAGE);
+    }
+    else if (0 == ::madvise(aligned, bytes, MADV_HUGEPAGE)) {
+        m_kind_ = page_kind::transparent;
+    }
+#endif
+    m_mapped_[static_cast<int>(m_kind_)] += bytes;
+    return aligned;
+}
+
+inline
+void *huge_page_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (alignment > region_size) {
+        throw std::bad_alloc();
+    }
+
+    const int index = size_class(bytes, alignment);
+    if (index < 0) {
+        return map(region_bytes(bytes));                              // RETURN
+    }
+
+    // A recycled block is maximally aligned, and may not suit an
+    // over-aligned request, which then takes a new block.
+
+    free_block *freed = m_free_[index];
+    if (freed && 0 == reinterpret_cast<std::uintptr_t>(freed) % alignment) {
+        m_free_[index] = freed->m_next_;
+        return freed;                                                 // RETURN
+    }
+
+    // Carve the block from the current region, or from a new one: regions
+    // are aligned to their size, which any alignment of a block divides.
+
+    const size_t size  = smallest_class << index;
+    const size_t align = std::max(alignment, alignof(std::max_align_t));
+    auto carve = [this, align]() {
+        return reinterpret_cast<char *>(
+                (reinterpret_cast<std::uintptr_t>(m_next_) + align - 1) /
+                                                           align * align);
+    };
+
+    char *result = carve();
+    if (!m_next_ || result + size > m_end_) {
+        char *fresh = static_cast<char *>(map(region_size));
+        try {
+            m_regions_.push_back(fresh);
+        }
+        catch (...) {
+            ::munmap(fresh, region_size);
+            throw;
+        }
+        m_next_ = fresh;
+        m_end_  = fresh + region_size;
+        result  = fresh;
+    }
+
+    m_next_ = result + size;
+    return result;
+}
+
+inline
+void huge_page_resource::do_deallocate(void   *p,
+                                       size_t  bytes,
+                                       size_t  alignment)
+{
+    const int index = size_class(bytes, alignment);
+    if (index < 0) {
+        ::munmap(p, region_bytes(bytes));
+        return;                                                       // RETURN
+    }
+
+    free_block *freed = static_cast<free_block *>(p);
+    freed->m_next_ = m_free_[index];
+    m_free_[index] = freed;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
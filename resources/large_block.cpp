@@ -0,0 +1,112 @@
+// large_block.cpp                                                    -*-C++-*-
+#include <large_block_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <cstring>
+
+void allocate_test(bool verbose);
+void resize_test  (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    allocate_test(verbose);
+    resize_test  (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void allocate_test(bool verbose)
+{
+    Framer framer{ "allocate", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    large_block_resource large{ 4096, &tr };
+    ASSERT_EQ(large.threshold(), 4096u);
+
+    // Small blocks come from upstream, large ones do not.
+
+    void *small = large.allocate(100);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+
+    char *big = static_cast<char *>(large.allocate(10000));
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    std::memset(big, 'x', 10000);
+
+    large.deallocate(big, 10000);
+    large.deallocate(small, 100);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+}
+
+void resize_test(bool verbose)
+{
+    Framer framer{ "resize in place", verbose };
+
+    std::pmr::test_resource tr{ "upstream" };
+    tr.set_verbose(verbose);
+
+    large_block_resource large{ 4096, &tr };
+    const size_t page = large_block_resource::mapped_size(1);
+
+    char *big = static_cast<char *>(large.allocate(8 * page));
+    std::memset(big, 'x', 8 * page);
+
+    // Within the last page, and shrinking, always succeed.
+
+    ASSERT(large.try_resize(big, 8 * page, 8 * page - 10));
+    ASSERT(large.try_resize(big, 8 * page - 10, 2 * page));
+    ASSERT_EQ(big[2 * page - 1], 'x');
+
+    // Growing succeeds only if the address space after the block is free,
+    // and keeps the contents when it does.
+
+    size_t size = 2 * page;
+    if (large.try_resize(big, size, 4 * page)) {
+        size = 4 * page;
+        ASSERT_EQ(big[0], 'x');
+        big[size - 1] = 'y';
+    }
+
+    // A block cannot cross the threshold, and a small block is resized only
+    // if the upstream resource can.
+
+    ASSERT(!large.try_resize(big, size, 100));
+    large.deallocate(big, size);
+
+    void *small = large.allocate(100);
+    ASSERT(!large.try_resize(small, 100, 200));
+    large.deallocate(small, 100);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,160 @@
+// large_block_resource.h                                             -*-C++-*-
+#ifndef LARGE_BLOCK_RESOURCE_H_INCLUDED
+#define LARGE_BLOCK_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <cstddef>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+class large_block_resource final : public std::pmr::extended_memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // Serve the blocks of at least a threshold size with a memory mapping of
+    // their own, and the smaller ones from an upstream resource.  A large
+    // block is resized in place with 'mremap', which remaps pages instead of
+    // copying bytes, as far as the address space after it is free; it can
+    // always shrink.  Large blocks are at most page aligned.  Requires
+    // Linux.
+
+    template <class, class>
+        friend class std::pmr::static_resource_allocator;
+
+    size_t                     m_threshold_;
+    std::pmr::memory_resource *m_upstream_;
+
+public:
+    explicit large_block_resource(
+              size_t                     threshold = 64 * 1024,
+              std::pmr::memory_resource *upstream =
+                                           std::pmr::get_default_resource())
+        // Create a resource mapping the blocks of at least the specified
+        // 'threshold' bytes, and allocating the others from the specified
+        // 'upstream' resource.
+    : m_threshold_(threshold)
+    , m_upstream_(upstream)
+    {
+    }
+
+    large_block_resource(const large_block_resource&) = delete;
+    large_block_resource& operator=(const large_block_resource&) = delete;
+
+    size_t threshold() const
+    {
+        return m_threshold_;
+    }
+
+    std::pmr::memory_resource *upstream_resource() const
+    {
+        return m_upstream_;
+    }
+
+    static size_t mapped_size(size_t bytes)
+        // Return the specified 'bytes' rounded up to whole pages.
+    {
+        static const size_t page =
+                             static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return (bytes + page - 1) / page * page;
+    }
+
+private:
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+
+    bool do_try_resize(void   *p,
+                       size_t  old_size,
+                       size_t  new_size,
+                       size_t  alignment) override;
+        // Resize a large block with 'mremap', or pass a small one on to the
+        // upstream resource.  A block cannot cross the threshold in place.
+};
+
+inline
+void *large_block_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (bytes < m_threshold_) {
+        return m_upstream_->allocate(bytes, alignment);               // RETURN
+    }
+
+    if (alignment > mapped_size(1)) {
+        throw std::bad_alloc();
+    }
+
+    void *result = ::mmap(nullptr,
+                          mapped_size(bytes),
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+    if (MAP_FAILED == result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+inline
+void large_block_resource::do_deallocate(void   *p,
+                                         size_t  bytes,
+                                         size_t  alignment)
+{
+    if (bytes < m_threshold_) {
+        m_upstream_->deallocate(p, bytes, alignment);
+    }
+    else {
+        ::munmap(p, mapped_size(bytes));
+    }
+}
+
+inline
+bool large_block_resource::do_try_resize(void   *p,
+                                         size_t  old_size,
+                                         size_t  new_size,
+                                         size_t  alignment)
+{
+    const bool wasLarge = old_size >= m_threshold_;
+    if (wasLarge != (new_size >= m_threshold_)) {
+        return false;                                                 // RETURN
+    }
+
+    if (!wasLarge) {
+        return std::pmr::try_resize(m_upstream_,
+                                    p, old_size, new_size, alignment);
+                                                                      // RETURN
+    }
+
+    const size_t oldMapped = mapped_size(old_size);
+    const size_t newMapped = mapped_size(new_size);
+    if (oldMapped == newMapped) {
+        return true;                                                  // RETURN
+    }
+
+    // Without 'MREMAP_MAYMOVE' the mapping keeps its address or fails.
+
+    return MAP_FAILED != ::mremap(p, oldMapped, newMapped, 0);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
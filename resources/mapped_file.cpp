@@ -0,0 +1,301 @@
+// mapped_file.cpp                                                    -*-C++-*-
+#include <mapped_file_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <pstring_last.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+void allocate_test(bool verbose);
+void grow_test    (bool verbose);
+void checked_test (bool verbose);
+void restart_test (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    allocate_test(verbose);
+    grow_test    (verbose);
+    checked_test (verbose);
+    restart_test (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+struct TemporaryFile {
+    // An empty file, removed on destruction.
+
+    char m_path_[32] = "/tmp/mapped_file_XXXXXX";
+
+    TemporaryFile()
+    {
+        ::close(::mkstemp(m_path_));
+    }
+
+    ~TemporaryFile()
+    {
+        ::unlink(m_path_);
+    }
+};
+
+void allocate_test(bool verbose)
+{
+    Framer framer{ "allocate", verbose };
+
+    TemporaryFile file;
+    mapped_file_resource mapped{ file.m_path_ };
+    ASSERT(mapped.same_address());
+    ASSERT_EQ(mapped.size(), size_t(1) << 20);
+
+    // Small blocks are rounded up to their size class.
+
+    const size_t start = mapped.used();
+    char *a = static_cast<char *>(mapped.allocate(10, 1));
+    char *b = static_cast<char *>(mapped.allocate(20, 8));
+    ASSERT_EQ(mapped.offset_of(a), start);
+    ASSERT_EQ(b, a + 16);
+    ASSERT_EQ(mapped.used(), start + 48);
+
+    // A freed block is reused by a block of the same class.
+
+    mapped.deallocate(a, 10, 1);
+    ASSERT_EQ(mapped.allocate(16, 16), static_cast<void *>(a));
+    mapped.deallocate(b, 20, 8);
+    ASSERT_EQ(mapped.allocate(32, 4), static_cast<void *>(b));
+
+    // Large or over-aligned blocks are not.
+
+    void *large = mapped.allocate(5000, 8);
+    mapped.deallocate(large, 5000, 8);
+    ASSERT((mapped.allocate(5000, 8) != large));
+
+    void *aligned = mapped.allocate(64, 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0u);
+    mapped.deallocate(aligned, 64, 64);
+    ASSERT((mapped.allocate(64, 64) != aligned));
+
+    // Without reuse, the resource only bumps.
+
+    TemporaryFile        other;
+    mapped_file_options  options;
+    options.reuse = false;
+    mapped_file_resource bumping{ other.m_path_, options };
+
+    char *c = static_cast<char *>(bumping.allocate(10, 1));
+    bumping.deallocate(c, 10, 1);
+    ASSERT_EQ(bumping.allocate(10, 1), static_cast<void *>(c + 10));
+
+    mapped.advise(MADV_RANDOM);
+    mapped.sync(false);
+}
+
+void grow_test(bool verbose)
+{
+    Framer framer{ "grow", verbose };
+
+    TemporaryFile file;
+
+    mapped_file_options options;
+    options.initial_size = 16384;
+    options.max_size     = 1 << 20;
+
+    mapped_file_resource mapped{ file.m_path_, options };
+    ASSERT_EQ(mapped.size(), 16384u);
+
+    // The file grows under the blocks already allocated, which stay put.
+
+    char *first = static_cast<char *>(mapped.allocate(10000, 1));
+    std::memset(first, 'a', 10000);
+    char *second = static_cast<char *>(mapped.allocate(10000, 1));
+    std::memset(second, 'b', 10000);
+    ASSERT_EQ(mapped.size(), 32768u);
+    ASSERT_EQ(first[9999], 'a');
+    ASSERT_EQ(second[9999], 'b');
+
+    (void)mapped.allocate(100000, 1);
+    ASSERT((mapped.size() >= mapped.used()));
+
+    // It never grows past its maximum size.
+
+    bool thrown = false;
+    try {
+        (void)mapped.allocate(1 << 20, 1);
+    }
+    catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+
+    // Nor does a size that would wrap around past the end of the file.
+
+    const size_t used = mapped.used();
+    for (size_t bytes : { SIZE_MAX, SIZE_MAX - 16 }) {
+        thrown = false;
+        try {
+            (void)mapped.allocate(bytes, 8);
+        }
+        catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        ASSERT(thrown);
+    }
+    ASSERT_EQ(mapped.used(), used);
+    ASSERT_EQ(first[0], 'a');
+
+    mapped.sync();
+}
+
+void checked_test(bool verbose)
+{
+    Framer framer{ "under test_resource", verbose };
+
+    TemporaryFile        file;
+    mapped_file_resource mapped{ file.m_path_ };
+
+    std::pmr::test_resource tr{ "mapped", &mapped };
+    tr.set_verbose(verbose);
+
+    {
+        std::pmr::vector<pstring> strings{ &tr };
+        for (int i = 0; i < 1000; ++i) {
+            strings.emplace_back(std::to_string(i) +
+                                  ": a string too long for the small buffer");
+        }
+        ASSERT_EQ(strings[999].str(),
+                  "999: a string too long for the small buffer");
+        for (const pstring& each : strings) {
+            ASSERT((mapped.offset_of(each.data()) < mapped.used()));
+        }
+    }
+    ASSERT_EQ(tr.blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+
+    // Strings may also use the mapped file directly.
+
+    pstring direct{ "a string too long for the small buffer", &mapped };
+    direct += direct;
+    ASSERT_EQ(direct.size(), 76u);
+}
+
+struct Index {
+    // Strings stored in a mapped file, by offset.
+
+    uint64_t m_count_;
+    uint64_t m_strings_[8];
+};
+
+void restart_test(bool verbose)
+{
+    Framer framer{ "restart", verbose };
+
+    TemporaryFile file;
+    uint64_t      used;
+
+    {
+        mapped_file_resource mapped{ file.m_path_ };
+
+        Index *index = static_cast<Index *>(mapped.allocate(sizeof(Index),
+                                                            alignof(Index)));
+        index->m_count_ = 8;
+        for (int i = 0; i < 8; ++i) {
+            std::string text = "entry " + std::to_string(i);
+            char *chars = static_cast<char *>(mapped.allocate(text.size() + 1,
+                                                              1));
+            std::memcpy(chars, text.c_str(), text.size() + 1);
+            index->m_strings_[i] = mapped.offset_of(chars);
+        }
+        mapped.set_root(index);
+
+        void *freed = mapped.allocate(100, 8);
+        mapped.deallocate(freed, 100, 8);
+        used = mapped.used();
+    }
+
+    // The data, and the free lists, are found again in the reopened file.
+
+    {
+        mapped_file_resource mapped{ file.m_path_ };
+        ASSERT_EQ(mapped.used(), used);
+
+        const Index *index = static_cast<const Index *>(mapped.root());
+        ASSERT((index != nullptr));
+        ASSERT_EQ(index->m_count_, 8u);
+        ASSERT_EQ(std::string(static_cast<const char *>(
+                                  mapped.address_of(index->m_strings_[7]))),
+                  "entry 7");
+
+        (void)mapped.allocate(100, 8);
+        ASSERT_EQ(mapped.used(), used);
+    }
+
+    // A file created without reuse keeps its blocks unrounded, and never
+    // reuses them, whatever the options it is reopened with.
+
+    TemporaryFile        other;
+    mapped_file_options  options;
+    options.reuse = false;
+    {
+        mapped_file_resource bumping{ other.m_path_, options };
+        (void)bumping.allocate(10, 1);
+    }
+    options.reuse = true;
+    {
+        mapped_file_resource bumping{ other.m_path_, options };
+        char *a = static_cast<char *>(bumping.allocate(20, 1));
+        char *b = static_cast<char *>(bumping.allocate(20, 1));
+        ASSERT_EQ(b, a + 20);
+        bumping.deallocate(a, 20, 1);
+        ASSERT_EQ(bumping.allocate(32, 1), static_cast<void *>(b + 20));
+    }
+
+    // A file of another kind is refused.
+
+    std::FILE *stream = std::fopen(file.m_path_, "w");
+    std::fputs("not a mapped file", stream);
+    std::fclose(stream);
+
+    bool thrown = false;
+    try {
+        mapped_file_resource mapped{ file.m_path_ };
+    }
+    catch (const std::system_error&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
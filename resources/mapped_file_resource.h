@@ -0,0 +1,369 @@
+// mapped_file_resource.h                                             -*-C++-*-
+#ifndef MAPPED_FILE_RESOURCE_H_INCLUDED
+#define MAPPED_FILE_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct mapped_file_options {
+    // This 'struct' holds the options of a 'mapped_file_resource'.
+
+    size_t initial_size{ size_t(1) << 20 };  // size of a new file
+    size_t max_size{ size_t(1) << 36 };      // largest size of the file
+    bool   reuse{ true };                    // recycle freed small blocks,
+                                             // kept by a reopened file
+};
+
+class mapped_file_resource final : public std::pmr::memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // Serve allocations from a file mapped into memory, so that data sets
+    // can be larger than RAM and outlive the process.  Blocks are carved in
+    // order from the mapping, which grows, together with the file, when it
+    // is exhausted; the address space for 'max_size' bytes is reserved up
+    // front, so blocks never move.  Optionally, freed blocks of up to 4096
+    // bytes, at most maximally aligned, are kept in free lists by size
+    // class, and reused; other freed blocks are not reused.  The free lists
+    // live in the file, and so does the choice to keep them: a reopened
+    // file keeps reusing blocks, or not, as it did when it was created.
+    //
+    // Reopening a file resumes where it was left.  The file remembers the
+    // address it was mapped at, and is mapped there again if possible, in
+    // which case the pointers stored in it are still valid; otherwise use
+    // offsets.  A 'root' offset is kept in the file to find the data again.
+    //
+    // The resource is not synchronized.  Requires POSIX.
+
+    static constexpr size_t   smallest_class = 16;
+    static constexpr int      class_count    = 9;  // 16 to 4096 bytes
+    static constexpr uint64_t file_magic     = 0x70313136306d6170;
+
+    struct alignas(std::max_align_t) file_header {
+        // This 'struct' is stored at the start of the file.
+
+        uint64_t m_magic_;
+        uint64_t m_base_;                 // address the file was mapped at
+        uint64_t m_used_;                 // offset of the first free byte
+        uint64_t m_root_;                 // offset of the root, 0 if none
+        uint64_t m_reuse_;                // 1 if freed blocks are reused
+        uint64_t m_free_[class_count];    // first free block of each class
+    };
+
+    int          m_fd_{ -1 };
+    char        *m_base_{ nullptr };      // the reserved address space
+    size_t       m_mapped_{ 0 };          // bytes of the file mapped
+    mapped_file_options
+                 m_options_;
+    bool         m_same_address_{ false };
+
+public:
+    explicit mapped_file_resource(const char          *path,
+                                  mapped_file_options  options = {});
+        // Open or create the file at 'path' and map it.  Throw
+        // 'std::system_error' on failure, or if the file exists but was not
+        // created by this class.
+
+    mapped_file_resource(const mapped_file_resource&) = delete;
+    mapped_file_resource& operator=(const mapped_file_resource&) = delete;
+
+    ~mapped_file_resource();
+
+    bool same_address() const
+        // Return 'true' if the file was mapped where it was when the data
+        // in it were written, which is always the case for a new file.
+    {
+        return m_same_address_;
+    }
+
+    size_t size() const
+        // Return the size of the file.
+    {
+        return m_mapped_;
+    }
+
+    size_t used() const
+        // Return the number of bytes of the file in use, header included.
+    {
+        return header()->m_used_;
+    }
+
+    uint64_t offset_of(const void *p) const
+        // Return the offset in the file of the byte at the specified 'p'.
+    {
+        return static_cast<const char *>(p) - m_base_;
+    }
+
+    void *address_of(uint64_t offset) const
+        // Return the address of the byte at the specified 'offset'.
+    {
+        return m_base_ + offset;
+    }
+
+    void set_root(const void *p)
+        // Record the specified 'p', in this resource, as the root of the
+        // data, or record no root if 'p' is 'nullptr'.
+    {
+        header()->m_root_ = p ? offset_of(p) : 0;
+    }
+
+    void *root() const
+        // Return the root of the data, or 'nullptr' if none was recorded.
+    {
+        return header()->m_root_ ? address_of(header()->m_root_) : nullptr;
+    }
+
+    void sync(bool wait = true);
+        // Write the modified pages to the file, and, if the specified 'wait'
+        // is 'true', wait until they are written.  Throw 'std::system_error'
+        // on failure.
+
+    void advise(int advice);
+        // Give the specified 'advice', one of the 'madvise' constants such
+        // as 'MADV_RANDOM' or 'MADV_WILLNEED', for the whole mapping.
+        // Throw 'std::system_error' on failure.
+
+private:
+    file_header *header() const
+    {
+        return reinterpret_cast<file_header *>(m_base_);
+    }
+
+    static int size_class(size_t bytes, size_t alignment)
+        // Return the size class of the blocks of the specified 'bytes' and
+        // 'alignment', or -1 if they are not recycled.
+    {
+        if (bytes > (smallest_class << (class_count - 1)) ||
+            alignment > alignof(std::max_align_t)) {
+            return -1;                                                // RETURN
+        }
+        int index = 0;
+        for (size_t size = smallest_class; size < bytes; size *= 2) {
+            ++index;
+        }
+        return index;
+    }
+
+    void grow(size_t needed);
+        // Extend the file and its mapping to at least the specified
+        // 'needed' bytes.  Throw 'std::bad_alloc' if that exceeds the
+        // maximum size, or the file cannot grow.
+
+    void map(size_t from, size_t to);
+        // Map the bytes of the file from the specified 'from' offset to the
+        // specified 'to' offset over the reserved address space.
+
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+};
+
+inline
+mapped_file_resource::mapped_file_resource(const char          *path,
+                                           mapped_file_options  options)
+: m_options_(options)
+{
+    m_fd_ = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (m_fd_ < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    auto fail = [this, path](int error) {
+        if (m_base_) {
+            ::munmap(m_base_, m_options_.max_size);
+        }
+        ::close(m_fd_);
+        throw std::system_error(error, std::generic_category(), path);
+    };
+
+    struct stat status;
+    if (::fstat(m_fd_, &status) < 0) {
+        fail(errno);
+    }
+    const size_t existing = static_cast<size_t>(status.st_size);
+
+    // Read the header, if any, to learn where the file was mapped before.
+
+    file_header stored{};
+    const bool  resume = 0 != existing;
+    if (resume &&
+        (::pread(m_fd_, &stored, sizeof stored, 0) !=
+                                      static_cast<ssize_t>(sizeof stored) ||
+         file_magic != stored.m_magic_)) {
+        fail(EINVAL);
+    }
+
+    const long page = ::sysconf(_SC_PAGESIZE);
+    m_mapped_ = resume ? existing : std::max(m_options_.initial_size,
+                                             sizeof(file_header));
+    m_mapped_ = (m_mapped_ + page - 1) / page * page;
+    m_options_.max_size = std::max(m_options_.max_size, m_mapped_);
+
+    // Reserve the address space, at the previous address if possible.
+
+    void *hint = resume ? reinterpret_cast<void *>(stored.m_base_) : nullptr;
+    void *reserved = ::mmap(hint,
+                            m_options_.max_size,
+                            PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                            -1,
+                            0);
+    if (MAP_FAILED == reserved) {
+        fail(errno);
+    }
+    m_base_         = static_cast<char *>(reserved);
+    m_same_address_ = !resume || hint == reserved;
+
+    if (!resume && ::ftruncate(m_fd_, m_mapped_) < 0) {
+        fail(errno);
+    }
+    try {
+        map(0, m_mapped_);
+    }
+    catch (const std::system_error& error) {
+        fail(error.code().value());
+    }
+
+    file_header *head = header();
+    if (!resume) {
+        *head          = file_header{};
+        head->m_magic_ = file_magic;
+        head->m_used_  = sizeof(file_header);
+        head->m_reuse_ = m_options_.reuse;
+    }
+    m_options_.reuse = 0 != head->m_reuse_;
+    head->m_base_ = reinterpret_cast<uintptr_t>(m_base_);
+}
+
+inline
+mapped_file_resource::~mapped_file_resource()
+{
+    ::munmap(m_base_, m_options_.max_size);
+    ::close(m_fd_);
+}
+
+inline
+void mapped_file_resource::map(size_t from, size_t to)
+{
+    void *mapped = ::mmap(m_base_ + from,
+                          to - from,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_FIXED,
+                          m_fd_,
+                          from);
+    if (MAP_FAILED == mapped) {
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+}
+
+inline
+void mapped_file_resource::grow(size_t needed)
+{
+    if (needed > m_options_.max_size) {
+        throw std::bad_alloc();
+    }
+
+    const long page = ::sysconf(_SC_PAGESIZE);
+    size_t size = std::min(std::max(2 * m_mapped_, needed),
+                           m_options_.max_size);
+    size = (size + page - 1) / page * page;
+
+    if (::ftruncate(m_fd_, size) < 0) {
+        throw std::bad_alloc();
+    }
+    map(m_mapped_, size);
+    m_mapped_ = size;
+}
+
+inline
+void *mapped_file_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    file_header *head  = header();
+    const int    index = m_options_.reuse ? size_class(bytes, alignment) : -1;
+
+    if (0 <= index) {
+        bytes     = smallest_class << index;
+        alignment = alignof(std::max_align_t);
+
+        if (head->m_free_[index]) {
+            void *result = address_of(head->m_free_[index]);
+            head->m_free_[index] = *static_cast<uint64_t *>(result);
+            return result;                                            // RETURN
+        }
+    }
+
+    const size_t start = (head->m_used_ + alignment - 1) / alignment *
+                                                                    alignment;
+    if (start > m_options_.max_size || bytes > m_options_.max_size - start) {
+        throw std::bad_alloc();
+    }
+    if (start + bytes > m_mapped_) {
+        grow(start + bytes);
+    }
+
+    head->m_used_ = start + bytes;
+    return m_base_ + start;
+}
+
+inline
+void mapped_file_resource::do_deallocate(void   *p,
+                                         size_t  bytes,
+                                         size_t  alignment)
+{
+    const int index = m_options_.reuse ? size_class(bytes, alignment) : -1;
+    if (index < 0) {
+        return;                                                       // RETURN
+    }
+
+    file_header *head = header();
+    *static_cast<uint64_t *>(p) = head->m_free_[index];
+    head->m_free_[index]        = offset_of(p);
+}
+
+inline
+void mapped_file_resource::sync(bool wait)
+{
+    if (::msync(m_base_, m_mapped_, wait ? MS_SYNC : MS_ASYNC) < 0) {
+        throw std::system_error(errno, std::generic_category(), "msync");
+    }
+}
+
+inline
+void mapped_file_resource::advise(int advice)
+{
+    if (::madvise(m_base_, m_mapped_, advice) < 0) {
+        throw std::system_error(errno, std::generic_category(), "madvise");
+    }
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
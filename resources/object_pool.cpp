@@ -0,0 +1,293 @@
+// object_pool.cpp                                                    -*-C++-*-
+#include <object_pool.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+void recycle_test     (bool verbose);
+void chunk_test       (bool verbose);
+void exception_test   (bool verbose);
+void release_test     (bool verbose);
+void thread_cache_test(bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    recycle_test     (verbose);
+    chunk_test       (verbose);
+    exception_test   (verbose);
+    release_test     (verbose);
+    thread_cache_test(verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+struct Node {
+    static std::atomic<int> s_live;
+
+    Node *m_next_;
+    long  m_value_;
+
+    explicit Node(long value, Node *next = nullptr)
+    : m_next_(next)
+    , m_value_(value)
+    {
+        if (value < 0) {
+            throw std::invalid_argument("negative node");
+        }
+        ++s_live;
+    }
+
+    ~Node()
+    {
+        --s_live;
+    }
+};
+
+std::atomic<int> Node::s_live{ 0 };
+
+void recycle_test(bool verbose)
+{
+    Framer framer{ "recycle slots", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    object_pool<Node> pool{ &tr };
+    ASSERT(trm.is_total_same());
+
+    Node *first = pool.new_object(1);
+    ASSERT_EQ(first->m_value_, 1);
+    ASSERT_EQ(Node::s_live.load(), 1);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+
+    // A freed slot is handed out again, without reaching the resource.
+
+    pool.delete_object(first);
+    ASSERT_EQ(Node::s_live.load(), 0);
+    Node *second = pool.new_object(2, nullptr);
+    ASSERT_EQ(second, first);
+    ASSERT_EQ(trm.delta_total_blocks(), 1);
+    pool.delete_object(second);
+
+    // The corrected 'polymorphic_allocator_P0339R5::new_object' returns the
+    // object.
+
+    std::pmr::polymorphic_allocator_P0339R5<> alloc{ &tr };
+    Node *direct = alloc.new_object<Node>(3);
+    ASSERT_EQ(direct->m_value_, 3);
+    alloc.delete_object(direct);
+    ASSERT_EQ(Node::s_live.load(), 0);
+}
+
+void chunk_test(bool verbose)
+{
+    Framer framer{ "chunks", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    object_pool_options options;
+    options.first_chunk = 4;
+    options.max_chunk   = 16;
+
+    object_pool<Node> pool{ options, &tr };
+
+    // Build a list of 100 nodes: chunks of 4, 8, 16, 16, ... slots.
+
+    Node *head = nullptr;
+    for (long i = 0; i < 100; ++i) {
+        head = pool.new_object(i, head);
+    }
+    ASSERT_EQ(pool.chunk_count(), 8u);
+    ASSERT_EQ(pool.capacity(), 108u);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 8);
+
+    std::set<Node *> distinct;
+    long             sum = 0;
+    for (Node *node = head; node; node = node->m_next_) {
+        distinct.insert(node);
+        sum += node->m_value_;
+    }
+    ASSERT_EQ(distinct.size(), 100u);
+    ASSERT_EQ(sum, 4950);
+
+    // Freeing and rebuilding the list allocates nothing more.
+
+    while (head) {
+        Node *next = head->m_next_;
+        pool.delete_object(head);
+        head = next;
+    }
+    for (long i = 0; i < 100; ++i) {
+        head = pool.new_object(i, head);
+    }
+    ASSERT_EQ(trm.delta_total_blocks(), 8);
+
+    while (head) {
+        Node *next = head->m_next_;
+        pool.delete_object(head);
+        head = next;
+    }
+}
+
+void exception_test(bool verbose)
+{
+    Framer framer{ "exceptions", verbose };
+
+    std::pmr::test_resource tr{ "upstream" };
+    tr.set_verbose(verbose);
+
+    object_pool<Node> pool{ &tr };
+
+    // A failed construction gives the slot back.
+
+    Node *kept = pool.new_object(1);
+    bool  thrown = false;
+    try {
+        (void)pool.new_object(-1);
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+    ASSERT_EQ(Node::s_live.load(), 1);
+
+    Node *next = pool.new_object(2);
+    ASSERT_EQ(next, kept + 1);
+    pool.delete_object(next);
+    pool.delete_object(kept);
+
+    // So does a failed allocation in 'polymorphic_allocator_P0339R5'.
+
+    std::pmr::test_resource_monitor trm{ tr };
+    std::pmr::polymorphic_allocator_P0339R5<> alloc{ &tr };
+    thrown = false;
+    try {
+        (void)alloc.new_object<Node>(-1);
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    ASSERT(thrown);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+}
+
+void release_test(bool verbose)
+{
+    Framer framer{ "release", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    {
+        object_pool_options options;
+        options.first_chunk = 8;
+
+        object_pool<long> pool{ options, &tr };
+        for (int i = 0; i < 20; ++i) {
+            *pool.allocate() = i;
+        }
+        ASSERT_EQ(trm.delta_blocks_in_use(), 2);
+
+        // The chunks go at once, live objects or not.
+
+        pool.release();
+        ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+        ASSERT_EQ(pool.capacity(), 0u);
+
+        (void)pool.allocate();
+        ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+}
+
+void thread_cache_test(bool verbose)
+{
+    Framer framer{ "thread cache", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    constexpr int threadCount = 4;
+    constexpr int rounds      = 1000;
+    constexpr int live        = 50;
+
+    for (size_t cacheSize : { 0, 16 }) {
+        object_pool_options options;
+        options.synchronized = true;
+        options.thread_cache = cacheSize;
+
+        object_pool<Node> pool{ options, &tr };
+
+        std::atomic<long> sum{ 0 };
+        auto work = [&]() {
+            std::vector<Node *> nodes;
+            for (int r = 0; r < rounds; ++r) {
+                for (int i = 0; i < live; ++i) {
+                    nodes.push_back(pool.new_object(i));
+                }
+                for (Node *node : nodes) {
+                    sum += node->m_value_;
+                    pool.delete_object(node);
+                }
+                nodes.clear();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back(work);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        ASSERT_EQ(sum.load(), 1225L * rounds * threadCount);
+        ASSERT_EQ(Node::s_live.load(), 0);
+
+        // The threads never hold more than their live nodes and caches.
+
+        ASSERT((pool.capacity() <=
+                                 2 * threadCount * (live + cacheSize) + 32));
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
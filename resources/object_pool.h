@@ -0,0 +1,405 @@
+// object_pool.h                                                      -*-C++-*-
+#ifndef OBJECT_POOL_H_INCLUDED
+#define OBJECT_POOL_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+
+struct object_pool_options {
+    // This 'struct' holds the options of an 'object_pool'.
+
+    size_t first_chunk{ 32 };       // objects in the first chunk
+    size_t max_chunk{ 4096 };       // objects in the largest chunks
+    bool   synchronized{ false };   // the pool is shared by threads
+    size_t thread_cache{ 0 };       // objects cached per thread, if
+                                    // 'synchronized', 0 for no cache
+};
+
+template <class T>
+class object_pool {
+    // This class is for demonstration purposes *only*.
+    //
+    // A pool of slots for objects of type 'T'.  Freed slots are linked in an
+    // intrusive free list and handed out again, and the pool refills the
+    // list with chunks of slots allocated from its memory resource, each
+    // chunk twice the size of the previous one up to a maximum.  The
+    // resource only sees the chunks, which are all deallocated at once by
+    // 'release' or the destructor, without destroying any live object.
+    //
+    // A synchronized pool may be used by several threads at once; the free
+    // list is then guarded by a mutex.  With a thread cache, each thread
+    // also keeps a few free slots of its own, and only takes the lock to
+    // exchange a batch of slots with the shared list.  The caches belong to
+    // the pool, and the slots cached by a thread that has exited are only
+    // recovered by 'release'.
+
+    union slot {
+        slot                     *m_next_;               // if free
+        alignas(T) unsigned char  m_bytes_[sizeof(T)];   // if in use
+    };
+
+    struct chunk {
+        chunk  *m_next_;   // previously allocated chunk
+        size_t  m_count_;  // slots in this chunk
+        // Followed, at the alignment of 'slot', by the slots.
+    };
+
+    struct cache {
+        std::thread::id  m_thread_;     // the thread owning this cache
+        slot            *m_free_;       // the cached slots
+        size_t           m_count_;      // number of cached slots
+        cache           *m_next_;       // cache of another thread
+    };
+
+    struct cache_hint {
+        // This 'struct' remembers, for the current thread, its cache in the
+        // pool it used most recently.
+
+        unsigned long long  m_serial_;  // serial of the owning pool
+        cache              *m_cache_;   // the cache of the thread
+    };
+
+    static constexpr size_t slots_offset =
+                 (sizeof(chunk) + alignof(slot) - 1) / alignof(slot) *
+                                                                alignof(slot);
+
+    static inline std::atomic<unsigned long long> s_next_serial_{ 1 };
+        // serial number handed to the next pool constructed
+
+    static inline thread_local cache_hint s_hint_{ 0, nullptr };
+
+public:
+    using allocator_type = std::pmr::polymorphic_allocator_P0339R5<>;
+
+    explicit object_pool(object_pool_options options = {},
+                         allocator_type      alloc   = {});
+        // Create a pool with the specified 'options', allocating its chunks
+        // with the specified 'alloc'.
+
+    explicit object_pool(allocator_type alloc)
+    : object_pool(object_pool_options{}, alloc)
+    {
+    }
+
+    object_pool(const object_pool&) = delete;
+    object_pool& operator=(const object_pool&) = delete;
+
+    ~object_pool();
+
+    [[nodiscard]] T *allocate();
+        // Return a slot for an object of type 'T', uninitialized.
+
+    void deallocate(T *object) noexcept;
+        // Return to the pool the slot of the specified 'object', already
+        // destroyed.
+
+    template <class... ArgTypes>
+    [[nodiscard]] T *new_object(ArgTypes&&... args)
+        // Return an object of type 'T' constructed in a slot of this pool
+        // from the specified 'args'.
+    {
+        T *object = allocate();
+        try {
+            ::new (static_cast<void *>(object))
+                                        T(std::forward<ArgTypes>(args)...);
+        }
+        catch (...) {
+            deallocate(object);
+            throw;
+        }
+        return object;
+    }
+
+    void delete_object(T *object) noexcept
+        // Destroy the specified 'object' and return its slot to the pool.
+    {
+        object->~T();
+        deallocate(object);
+    }
+
+    void release() noexcept;
+        // Deallocate all the chunks, without destroying the objects in them.
+        // The behavior is undefined if another thread uses the pool
+        // meanwhile.
+
+    size_t chunk_count() const
+        // Return the number of chunks allocated.
+    {
+        return m_chunk_count_;
+    }
+
+    size_t capacity() const
+        // Return the number of slots in all the chunks.
+    {
+        return m_capacity_;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_allocator_;
+    }
+
+private:
+    cache *thread_cache();
+        // Return the cache of the calling thread, created on first use.
+        // The behavior is undefined unless the pool has thread caches.
+
+    void refill();
+        // Add a chunk of slots to the free list.  The behavior is undefined
+        // unless the free list is empty, and the lock is held if the pool is
+        // synchronized.
+
+    slot *take(size_t count, size_t *taken);
+        // Unlink from the free list at most the specified 'count' slots,
+        // refilling it if empty, and return them as a list, loading
+        // 'taken' with their number.  The behavior is undefined unless the
+        // lock is held.
+
+    allocator_type      m_allocator_;
+    object_pool_options m_options_;
+    unsigned long long  m_serial_;
+    size_t              m_next_chunk_;   // slots in the next chunk
+    size_t              m_chunk_count_{ 0 };
+    size_t              m_capacity_{ 0 };
+    chunk              *m_chunks_{ nullptr };
+    slot               *m_free_{ nullptr };
+    cache              *m_caches_{ nullptr };
+    std::mutex          m_lock_;
+};
+
+template <class T>
+object_pool<T>::object_pool(object_pool_options options,
+                            allocator_type      alloc)
+: m_allocator_(alloc)
+, m_options_(options)
+, m_serial_(s_next_serial_.fetch_add(1, std::memory_order_relaxed))
+, m_next_chunk_(std::max<size_t>(options.first_chunk, 1))
+{
+    if (!m_options_.synchronized) {
+        m_options_.thread_cache = 0;
+    }
+    m_options_.max_chunk = std::max(m_options_.max_chunk, m_next_chunk_);
+}
+
+template <class T>
+object_pool<T>::~object_pool()
+{
+    release();
+
+    while (m_caches_) {
+        cache *next = m_caches_->m_next_;
+        m_allocator_.deallocate_object(m_caches_);
+        m_caches_ = next;
+    }
+}
+
+template <class T>
+void object_pool<T>::refill()
+{
+    const size_t count = m_next_chunk_;
+
+    void *raw = m_allocator_.allocate_bytes(
+                                     slots_offset + count * sizeof(slot),
+                                     std::max(alignof(chunk), alignof(slot)));
+    chunk *fresh    = static_cast<chunk *>(raw);
+    fresh->m_next_  = m_chunks_;
+    fresh->m_count_ = count;
+    m_chunks_       = fresh;
+
+    // Link the slots in address order, so they are handed out in order.
+
+    slot *slots = reinterpret_cast<slot *>(static_cast<char *>(raw) +
+                                                                slots_offset);
+    for (size_t i = 0; i + 1 < count; ++i) {
+        slots[i].m_next_ = slots + i + 1;
+    }
+    slots[count - 1].m_next_ = m_free_;
+    m_free_                  = slots;
+
+    ++m_chunk_count_;
+    m_capacity_  += count;
+    m_next_chunk_  = std::min(2 * count, m_options_.max_chunk);
+}
+
+template <class T>
+typename object_pool<T>::slot *object_pool<T>::take(size_t  count,
+                                                    size_t *taken)
+{
+    if (!m_free_) {
+        refill();
+    }
+
+    slot   *first = m_free_;
+    slot   *last  = first;
+    size_t  found = 1;
+    while (found < count && last->m_next_) {
+        last = last->m_next_;
+        ++found;
+    }
+
+    m_free_        = last->m_next_;
+    last->m_next_  = nullptr;
+    *taken         = found;
+    return first;
+}
+
+template <class T>
+typename object_pool<T>::cache *object_pool<T>::thread_cache()
+{
+    if (s_hint_.m_serial_ == m_serial_) {
+        return s_hint_.m_cache_;                                      // RETURN
+    }
+
+    const std::thread::id id = std::this_thread::get_id();
+
+    std::lock_guard<std::mutex> guard{ m_lock_ };
+
+    cache *found = m_caches_;
+    while (found && found->m_thread_ != id) {
+        found = found->m_next_;
+    }
+
+    if (!found) {
+        found = m_allocator_.allocate_object<cache>();
+        *found = { id, nullptr, 0, m_caches_ };
+        m_caches_ = found;
+    }
+
+    s_hint_ = { m_serial_, found };
+    return found;
+}
+
+template <class T>
+T *object_pool<T>::allocate()
+{
+    if (!m_options_.synchronized) {
+        if (!m_free_) {
+            refill();
+        }
+        slot *result = m_free_;
+        m_free_ = result->m_next_;
+        return reinterpret_cast<T *>(result);                         // RETURN
+    }
+
+    if (0 == m_options_.thread_cache) {
+        std::lock_guard<std::mutex> guard{ m_lock_ };
+
+        size_t taken;
+        return reinterpret_cast<T *>(take(1, &taken));                // RETURN
+    }
+
+    cache *mine = thread_cache();
+    if (!mine->m_free_) {
+        // Take half a cache worth of slots, so that alternating allocations
+        // and deallocations do not take the lock every time.
+
+        std::lock_guard<std::mutex> guard{ m_lock_ };
+        mine->m_free_ = take((m_options_.thread_cache + 1) / 2,
+                             &mine->m_count_);
+    }
+
+    slot *result  = mine->m_free_;
+    mine->m_free_ = result->m_next_;
+    --mine->m_count_;
+    return reinterpret_cast<T *>(result);
+}
+
+template <class T>
+void object_pool<T>::deallocate(T *object) noexcept
+{
+    slot *freed = reinterpret_cast<slot *>(object);
+
+    if (!m_options_.synchronized) {
+        freed->m_next_ = m_free_;
+        m_free_        = freed;
+        return;                                                       // RETURN
+    }
+
+    if (0 == m_options_.thread_cache) {
+        std::lock_guard<std::mutex> guard{ m_lock_ };
+
+        freed->m_next_ = m_free_;
+        m_free_        = freed;
+        return;                                                       // RETURN
+    }
+
+    cache *mine = thread_cache();
+    freed->m_next_ = mine->m_free_;
+    mine->m_free_  = freed;
+    if (++mine->m_count_ < m_options_.thread_cache) {
+        return;                                                       // RETURN
+    }
+
+    // The cache is full: give half of it back to the shared list.
+
+    const size_t kept = m_options_.thread_cache / 2;
+    slot *last = mine->m_free_;
+    for (size_t i = 1; i < kept; ++i) {
+        last = last->m_next_;
+    }
+    slot *given = kept ? last->m_next_ : mine->m_free_;
+    slot *end   = given;
+    while (end->m_next_) {
+        end = end->m_next_;
+    }
+    if (kept) {
+        last->m_next_ = nullptr;
+    }
+    else {
+        mine->m_free_ = nullptr;
+    }
+    mine->m_count_ = kept;
+
+    std::lock_guard<std::mutex> guard{ m_lock_ };
+    end->m_next_ = m_free_;
+    m_free_      = given;
+}
+
+template <class T>
+void object_pool<T>::release() noexcept
+{
+    while (m_chunks_) {
+        chunk *next = m_chunks_->m_next_;
+        m_allocator_.deallocate_bytes(
+                          m_chunks_,
+                          slots_offset + m_chunks_->m_count_ * sizeof(slot),
+                          std::max(alignof(chunk), alignof(slot)));
+        m_chunks_ = next;
+    }
+
+    // The caches stay allocated, empty, as threads may still hold them.
+
+    for (cache *each = m_caches_; each; each = each->m_next_) {
+        each->m_free_  = nullptr;
+        each->m_count_ = 0;
+    }
+
+    m_free_       = nullptr;
+    m_chunk_count_ = 0;
+    m_capacity_   = 0;
+    m_next_chunk_  = std::max<size_t>(m_options_.first_chunk, 1);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,210 @@
+// stack_buffer.cpp                                                   -*-C++-*-
+#include <stack_buffer_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <pstring_last.h>
+
+#include <cstdint>
+#include <new>
+#include <string>
+
+void lifo_test        (bool verbose);
+void fallback_test    (bool verbose);
+void out_of_order_test(bool verbose);
+void string_test      (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    lifo_test        (verbose);
+    fallback_test    (verbose);
+    out_of_order_test(verbose);
+    string_test      (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void lifo_test(bool verbose)
+{
+    Framer framer{ "LIFO reuse", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    stack_buffer_resource<256> resource{ &tr };
+    ASSERT_EQ(resource.upstream_resource(), &tr);
+
+    // Blocks are stacked at the maximal alignment.
+
+    char *a = static_cast<char *>(resource.allocate(10, 1));
+    char *b = static_cast<char *>(resource.allocate(20, 8));
+    char *c = static_cast<char *>(resource.allocate(1, 1));
+    ASSERT_EQ(b, a + 16);
+    ASSERT_EQ(c, b + 32);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(a) %
+                                                alignof(std::max_align_t), 0u);
+    ASSERT_EQ(resource.bytes_in_use(), 64u);
+
+    // Freed in LIFO order, their bytes are all reused.
+
+    resource.deallocate(c, 1, 1);
+    resource.deallocate(b, 20, 8);
+    ASSERT_EQ(resource.bytes_in_use(), 16u);
+    ASSERT_EQ(resource.allocate(40, 8), static_cast<void *>(b));
+    resource.deallocate(b, 40, 8);
+    resource.deallocate(a, 10, 1);
+    ASSERT_EQ(resource.bytes_in_use(), 0u);
+
+    ASSERT_EQ(resource.allocations(), 4u);
+    ASSERT_EQ(resource.fallbacks(), 0u);
+    ASSERT_EQ(resource.high_water(), 64u);
+    ASSERT(trm.is_total_same());
+}
+
+void fallback_test(bool verbose)
+{
+    Framer framer{ "fallback", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    stack_buffer_resource<100> resource{ &tr };
+
+    // What does not fit goes upstream, and comes back there.
+
+    void *a = resource.allocate(64, 8);
+    void *b = resource.allocate(64, 8);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    ASSERT_EQ(tr.last_allocated_num_bytes(), 64);
+    void *c = resource.allocate(32, 8);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+
+    resource.deallocate(b, 64, 8);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    resource.deallocate(c, 32, 8);
+    resource.deallocate(a, 64, 8);
+
+    ASSERT_EQ(resource.allocations(), 3u);
+    ASSERT_EQ(resource.fallbacks(), 1u);
+    ASSERT_EQ(resource.high_water(), 96u);
+
+    // So does a size that would wrap around once rounded, and the buffer
+    // does not grow a block to it.
+
+    for (size_t bytes : { SIZE_MAX, SIZE_MAX - 8 }) {
+        bool thrown = false;
+        try {
+            (void)resource.allocate(bytes, 8);
+        }
+        catch (const std::bad_alloc&) {
+            thrown = true;
+        }
+        ASSERT(thrown);
+    }
+    ASSERT_EQ(resource.fallbacks(), 3u);
+
+    void *d = resource.allocate(16, 8);
+    ASSERT(!resource.try_resize(d, 16, SIZE_MAX - 8, 8));
+    ASSERT_EQ(resource.allocate(16, 8), static_cast<void *>(
+                                            static_cast<char *>(d) + 16));
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+}
+
+void out_of_order_test(bool verbose)
+{
+    Framer framer{ "out of order", verbose };
+
+    stack_buffer_resource<1024> resource{ std::pmr::null_memory_resource() };
+
+    // A block freed out of order stays in use until the buffer is empty.
+
+    void *a = resource.allocate(16, 8);
+    void *b = resource.allocate(16, 8);
+    void *c = resource.allocate(16, 8);
+    resource.deallocate(b, 16, 8);
+    ASSERT_EQ(resource.bytes_in_use(), 48u);
+    resource.deallocate(c, 16, 8);
+    ASSERT_EQ(resource.bytes_in_use(), 32u);
+    resource.deallocate(a, 16, 8);
+    ASSERT_EQ(resource.bytes_in_use(), 0u);
+}
+
+void string_test(bool verbose)
+{
+    Framer framer{ "strings", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    stack_buffer_resource<1024> resource{ &tr };
+
+    // Temporary strings cost no heap allocation.
+
+    {
+        std::pmr::string joined{ &resource };
+        for (int i = 0; i < 20; ++i) {
+            joined += "word ";
+        }
+        std::pmr::string copy{ joined, &resource };
+        copy += copy;
+        ASSERT_EQ(copy.size(), 200u);
+    }
+    ASSERT(trm.is_total_same());
+    ASSERT_EQ(resource.bytes_in_use(), 0u);
+
+    // A growing 'pstring' on top of the stack is resized in place.
+
+    {
+        pstring built{ "a string too long for the small buffer", &resource };
+        const char *chars = built.data();
+        for (int i = 0; i < 400; ++i) {
+            built += 'x';
+        }
+        ASSERT_EQ(built.data(), chars);
+        ASSERT_EQ(built.size(), 438u);
+
+        // Past the buffer, it moves upstream.
+
+        for (int i = 0; i < 1000; ++i) {
+            built += 'y';
+        }
+        ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+        ASSERT((resource.fallbacks() > 0));
+        ASSERT_EQ(built.size(), 1438u);
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT_EQ(resource.bytes_in_use(), 0u);
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
@@ -0,0 +1,215 @@
+// stack_buffer_resource.h                                            -*-C++-*-
+#ifndef STACK_BUFFER_RESOURCE_H_INCLUDED
+#define STACK_BUFFER_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+template <size_t N>
+class stack_buffer_resource final : public std::pmr::extended_memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // Serve allocations from a buffer of 'N' bytes inside the object, meant
+    // to live on the stack, and from an upstream resource once the buffer
+    // is exhausted.  Blocks are stacked in the buffer, their sizes rounded
+    // up to the maximal alignment, so that freeing the top block gives its
+    // bytes back, and blocks freed in LIFO order are all reused; a block
+    // freed out of order is only reused once every block in the buffer is
+    // freed.  Over-aligned blocks always come from upstream.  The top block
+    // can be resized in place, as far as the buffer allows.
+    //
+    // The counts of allocations, of those falling back to upstream, and
+    // the most bytes of the buffer ever in use tell how large 'N' should
+    // be.
+
+    template <class, class>
+        friend class std::pmr::static_resource_allocator;
+
+    static constexpr size_t granule = alignof(std::max_align_t);
+
+    alignas(std::max_align_t) unsigned char m_buffer_[N];
+
+    std::pmr::memory_resource *m_upstream_;
+    unsigned char             *m_next_;          // first free byte
+    size_t                     m_live_{ 0 };     // blocks in the buffer
+    size_t                     m_allocations_{ 0 };
+    size_t                     m_fallbacks_{ 0 };
+    size_t                     m_high_water_{ 0 };
+
+public:
+    explicit stack_buffer_resource(
+              std::pmr::memory_resource *upstream =
+                                           std::pmr::get_default_resource())
+        // Create a resource falling back to the specified 'upstream'
+        // resource once its buffer is exhausted.
+    : m_upstream_(upstream)
+    , m_next_(m_buffer_)
+    {
+    }
+
+    stack_buffer_resource(const stack_buffer_resource&) = delete;
+    stack_buffer_resource& operator=(const stack_buffer_resource&) = delete;
+
+    size_t allocations() const
+        // Return the number of allocations so far.
+    {
+        return m_allocations_;
+    }
+
+    size_t fallbacks() const
+        // Return the number of allocations served by upstream so far.
+    {
+        return m_fallbacks_;
+    }
+
+    size_t high_water() const
+        // Return the most bytes of the buffer ever in use.
+    {
+        return m_high_water_;
+    }
+
+    size_t bytes_in_use() const
+        // Return the number of bytes of the buffer in use.
+    {
+        return m_next_ - m_buffer_;
+    }
+
+    std::pmr::memory_resource *upstream_resource() const
+    {
+        return m_upstream_;
+    }
+
+private:
+    static size_t rounded(size_t bytes)
+    {
+        return (bytes + granule - 1) / granule * granule;
+    }
+
+    bool owns(const void *p) const
+    {
+        std::less<const void *> before;
+        return !before(p, m_buffer_) && before(p, m_buffer_ + N);
+    }
+
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+
+    std::pmr::allocation_result<void *> do_allocate_at_least(
+                                                    size_t bytes,
+                                                    size_t alignment) override
+        // Allocate a block and report its size in the buffer, rounded up.
+    {
+        void *result = do_allocate(bytes, alignment);
+        return { result, owns(result) ? rounded(std::max<size_t>(bytes, 1))
+                                      : bytes };
+    }
+
+    bool do_try_resize(void   *p,
+                       size_t  old_size,
+                       size_t  new_size,
+                       size_t  alignment) override;
+        // Resize the block at the specified 'p' and return 'true' if it is
+        // in the buffer and either keeps its rounded size or is the top
+        // block and fits; pass an upstream block on to upstream.
+};
+
+template <size_t N>
+void *stack_buffer_resource<N>::do_allocate(size_t bytes, size_t alignment)
+{
+    ++m_allocations_;
+
+    // A block larger than the buffer goes upstream before its size is
+    // rounded, which could wrap around.
+
+    if (bytes > N ||
+        alignment > granule ||
+        static_cast<size_t>(m_buffer_ + N - m_next_) <
+                                       rounded(std::max<size_t>(bytes, 1))) {
+        ++m_fallbacks_;
+        return m_upstream_->allocate(bytes, alignment);               // RETURN
+    }
+
+    void *result = m_next_;
+    m_next_ += rounded(std::max<size_t>(bytes, 1));
+    ++m_live_;
+    m_high_water_ = std::max(m_high_water_, bytes_in_use());
+    return result;
+}
+
+template <size_t N>
+void stack_buffer_resource<N>::do_deallocate(void   *p,
+                                             size_t  bytes,
+                                             size_t  alignment)
+{
+    if (!owns(p)) {
+        m_upstream_->deallocate(p, bytes, alignment);
+        return;                                                       // RETURN
+    }
+
+    if (0 == --m_live_) {
+        m_next_ = m_buffer_;
+    }
+    else if (static_cast<unsigned char *>(p) +
+                                  rounded(std::max<size_t>(bytes, 1)) ==
+                                                                    m_next_) {
+        m_next_ = static_cast<unsigned char *>(p);
+    }
+}
+
+template <size_t N>
+bool stack_buffer_resource<N>::do_try_resize(void   *p,
+                                             size_t  old_size,
+                                             size_t  new_size,
+                                             size_t  alignment)
+{
+    if (!owns(p)) {
+        return std::pmr::try_resize(m_upstream_,
+                                    p, old_size, new_size, alignment);
+                                                                      // RETURN
+    }
+
+    if (new_size > N) {
+        return false;                                                 // RETURN
+    }
+
+    unsigned char *block   = static_cast<unsigned char *>(p);
+    const size_t   oldSize = rounded(std::max<size_t>(old_size, 1));
+    const size_t   newSize = rounded(std::max<size_t>(new_size, 1));
+    if (oldSize == newSize) {
+        return true;                                                  // RETURN
+    }
+    if (block + oldSize != m_next_ ||
+        static_cast<size_t>(m_buffer_ + N - block) < newSize) {
+        return false;                                                 // RETURN
+    }
+
+    m_next_       = block + newSize;
+    m_high_water_ = std::max(m_high_water_, bytes_in_use());
+    return true;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
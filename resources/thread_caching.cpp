@@ -0,0 +1,267 @@
+// thread_caching.cpp                                                 -*-C++-*-
+#include <thread_caching_resource.h>
+
+#include <supportlib/framer.h>
+
+#define SUPPORTLIB_ASSERT_REGISTER_ERROR ++errorCount;
+#include <supportlib/assert.h>
+
+#include <memory_resource_p1160>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+void cache_test      (bool verbose);
+void bypass_test     (bool verbose);
+void thread_exit_test(bool verbose);
+void cross_free_test (bool verbose);
+void destroy_test    (bool verbose);
+
+int errorCount{ 0 };
+
+void tests(bool verbose)
+{
+    cache_test      (verbose);
+    bypass_test     (verbose);
+    thread_exit_test(verbose);
+    cross_free_test (verbose);
+    destroy_test    (verbose);
+}
+
+int main()
+{
+    tests(false);
+
+    tests(true);
+
+    return errorCount;
+}
+
+void cache_test(bool verbose)
+{
+    Framer framer{ "cache", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    thread_caching_options options;
+    options.batch = 4;
+
+    {
+        thread_caching_resource resource{ options, &tr };
+        ASSERT_EQ(resource.upstream_resource(), &tr);
+
+        // The first allocation takes a batch from upstream.
+
+        void *blocks[10];
+        blocks[0] = resource.allocate(24, 8);
+        ASSERT_EQ(trm.delta_blocks_in_use(), 4);
+        ASSERT_EQ(tr.last_allocated_num_bytes(), 32);
+        for (int i = 1; i < 10; ++i) {
+            blocks[i] = resource.allocate(32, 16);
+        }
+        ASSERT_EQ(trm.delta_blocks_in_use(), 12);
+
+        thread_caching_stats stats = resource.stats();
+        ASSERT_EQ(stats.hits, 7u);
+        ASSERT_EQ(stats.misses, 3u);
+        ASSERT_EQ(stats.bypassed, 0u);
+
+        // Freed blocks are handed out again, until two batches are cached,
+        // when one goes back.
+
+        resource.deallocate(blocks[9], 32, 16);
+        ASSERT_EQ(resource.allocate(17, 1), blocks[9]);
+        for (int i = 0; i < 10; ++i) {
+            resource.deallocate(blocks[i], 32, 8);
+        }
+        ASSERT_EQ(trm.delta_blocks_in_use(), 4);
+        ASSERT_EQ(resource.stats().hits, 8u);
+
+        resource.flush();
+        ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+        void *last = resource.allocate(1, 1);
+        ASSERT_EQ(trm.delta_blocks_in_use(), 4);
+        resource.deallocate(last, 1, 1);
+    }
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+}
+
+void bypass_test(bool verbose)
+{
+    Framer framer{ "bypass", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+    tr.set_verbose(verbose);
+
+    thread_caching_resource resource{ &tr };
+
+    // Large blocks go straight to upstream.
+
+    void *large = resource.allocate(2000, 8);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 1);
+    ASSERT_EQ(tr.last_allocated_num_bytes(), 2000);
+    resource.deallocate(large, 2000, 8);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    thread_caching_stats stats = resource.stats();
+    ASSERT_EQ(stats.bypassed, 1u);
+    ASSERT_EQ(stats.hits + stats.misses, 0u);
+    ASSERT_EQ(stats.hit_rate(), 0.0);
+}
+
+void thread_exit_test(bool verbose)
+{
+    Framer framer{ "thread exit", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+
+    constexpr int threadCount = 4;
+    constexpr int rounds      = 1000;
+
+    thread_caching_resource resource{ &tr };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&resource]() {
+            for (int r = 0; r < rounds; ++r) {
+                std::pmr::vector<int> values{ &resource };
+                for (int i = 0; i < 20; ++i) {
+                    values.push_back(i);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // The threads gave their caches back as they exited.
+
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+
+    thread_caching_stats stats = resource.stats();
+    ASSERT_EQ(stats.hits + stats.misses, 6u * rounds * threadCount);
+    ASSERT((stats.hit_rate() > 0.99));
+}
+
+void cross_free_test(bool verbose)
+{
+    Framer framer{ "freed by another thread", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+
+    constexpr int count = 10000;
+
+    thread_caching_resource resource{ &tr };
+
+    std::mutex              lock;
+    std::condition_variable ready;
+    std::deque<long *>      queue;
+
+    std::thread producer([&]() {
+        std::pmr::polymorphic_allocator_P0339R5<> alloc{ &resource };
+        for (long i = 0; i < count; ++i) {
+            long *value = alloc.new_object<long>(i);
+            std::lock_guard<std::mutex> guard{ lock };
+            queue.push_back(value);
+            ready.notify_one();
+        }
+    });
+
+    long sum = 0;
+    std::thread consumer([&]() {
+        std::pmr::polymorphic_allocator_P0339R5<> alloc{ &resource };
+        for (long i = 0; i < count; ++i) {
+            std::unique_lock<std::mutex> guard{ lock };
+            ready.wait(guard, [&queue]() { return !queue.empty(); });
+            long *value = queue.front();
+            queue.pop_front();
+            guard.unlock();
+
+            sum += *value;
+            alloc.delete_object(value);
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    ASSERT_EQ(sum, count * (count - 1L) / 2);
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+}
+
+void destroy_test(bool verbose)
+{
+    Framer framer{ "destroyed before threads exit", verbose };
+
+    std::pmr::test_resource          tr{ "upstream" };
+    std::pmr::test_resource_monitor trm{ tr };
+
+    std::mutex              lock;
+    std::condition_variable changed;
+    int                     step = 0;
+
+    auto resource = std::make_unique<thread_caching_resource>(&tr);
+
+    std::thread worker([&]() {
+        void *block = resource->allocate(100, 8);
+        resource->deallocate(block, 100, 8);
+
+        std::unique_lock<std::mutex> guard{ lock };
+        step = 1;
+        changed.notify_one();
+        changed.wait(guard, [&step]() { return 2 == step; });
+
+        // The thread outlives the resource, then uses another one.
+
+        thread_caching_resource other{ &tr };
+        other.deallocate(other.allocate(8, 8), 8, 8);
+    });
+
+    {
+        std::unique_lock<std::mutex> guard{ lock };
+        changed.wait(guard, [&step]() { return 1 == step; });
+    }
+    ASSERT((trm.delta_blocks_in_use() > 0));
+    resource.reset();
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+
+    {
+        std::lock_guard<std::mutex> guard{ lock };
+        step = 2;
+        changed.notify_one();
+    }
+    worker.join();
+
+    ASSERT_EQ(trm.delta_blocks_in_use(), 0);
+    ASSERT(!tr.has_errors());
+}
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
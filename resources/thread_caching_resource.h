@@ -0,0 +1,432 @@
+// thread_caching_resource.h                                          -*-C++-*-
+#ifndef THREAD_CACHING_RESOURCE_H_INCLUDED
+#define THREAD_CACHING_RESOURCE_H_INCLUDED
+
+#include <memory_resource_p1160>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+struct thread_caching_options {
+    // This 'struct' holds the options of a 'thread_caching_resource'.
+
+    size_t max_block{ 1024 };   // largest block cached
+    size_t batch{ 32 };         // blocks moved to or from upstream at once
+};
+
+struct thread_caching_stats {
+    // This 'struct' counts the allocations of a 'thread_caching_resource'.
+
+    size_t hits;                // served from a thread cache
+    size_t misses;              // served after refilling a thread cache
+    size_t bypassed;            // too large or over-aligned to be cached
+
+    double hit_rate() const
+        // Return the share of the cacheable allocations served from a
+        // thread cache, or 0 if there were none.
+    {
+        const size_t cacheable = hits + misses;
+        return cacheable ? static_cast<double>(hits) / cacheable : 0;
+    }
+};
+
+class thread_caching_resource final : public std::pmr::memory_resource {
+    // This class is for demonstration purposes *only*.
+    //
+    // Keep, for each thread, a magazine of free blocks of each size class,
+    // so that most allocations and deallocations take no lock.  Blocks are
+    // rounded up to a power of two, at least 16 bytes, maximally aligned;
+    // larger or over-aligned blocks go straight to the upstream resource,
+    // which must be thread safe, and may not be another resource of this
+    // class.  An empty magazine takes a batch of blocks from upstream; a
+    // magazine holding two batches gives one back.
+    //
+    // A block may be freed by another thread than the one that allocated
+    // it: all the blocks of a class are alike.  The cache of a thread is
+    // given back to upstream when the thread exits, or when the resource is
+    // destroyed, whichever comes first.  Blocks freed by a thread after its
+    // thread local objects are destroyed go straight to upstream.
+
+    static constexpr size_t smallest_class = 16;
+    static constexpr int    max_classes    = 16;   // 16 bytes to 512 KiB
+
+    struct free_block {
+        free_block *m_next_;
+    };
+
+    struct magazine {
+        free_block *m_free_;
+        size_t      m_count_;
+    };
+
+    struct cache {
+        // The cache of a thread in a resource; only the thread uses its
+        // magazines, while the resource is alive.
+
+        thread_caching_resource *m_resource_;   // null once destroyed
+        cache                   *m_next_in_resource_;
+        cache                   *m_next_in_thread_;
+        std::atomic<size_t>      m_hits_;       // written by the thread
+        std::atomic<size_t>      m_misses_;     // only
+        magazine                 m_magazines_[max_classes];
+    };
+
+    struct thread_caches {
+        // The caches of a thread, given back when it exits.  Only thread
+        // local objects, zero initialized, are created.
+
+        cache *m_first_;
+
+        ~thread_caches();
+    };
+
+    struct cache_hint {
+        // The cache of the current thread in the resource it used most
+        // recently.
+
+        unsigned long long  m_serial_;
+        cache              *m_cache_;
+    };
+
+    static inline std::mutex s_lock_;
+        // guards the lists of caches of all threads and resources
+
+    static inline std::atomic<unsigned long long> s_next_serial_{ 1 };
+
+    static inline thread_local cache_hint    s_hint_{ 0, nullptr };
+    static inline thread_local thread_caches s_caches_;
+    static inline thread_local bool          s_exited_{ false };
+
+    std::pmr::memory_resource *m_upstream_;
+    thread_caching_options     m_options_;
+    unsigned long long         m_serial_;
+    cache                     *m_caches_{ nullptr };
+    size_t                     m_hits_{ 0 };     // of the retired caches
+    size_t                     m_misses_{ 0 };
+    std::atomic<size_t>        m_bypassed_{ 0 };
+
+public:
+    explicit thread_caching_resource(
+              thread_caching_options     options  = {},
+              std::pmr::memory_resource *upstream =
+                                           std::pmr::get_default_resource());
+        // Create a resource caching the blocks of the specified 'upstream'
+        // resource, as the specified 'options' say.
+
+    explicit thread_caching_resource(std::pmr::memory_resource *upstream)
+    : thread_caching_resource(thread_caching_options{}, upstream)
+    {
+    }
+
+    thread_caching_resource(const thread_caching_resource&) = delete;
+    thread_caching_resource& operator=(
+                                    const thread_caching_resource&) = delete;
+
+    ~thread_caching_resource();
+        // Give the caches of all threads back to upstream.  The behavior is
+        // undefined if another thread uses the resource meanwhile.
+
+    void flush();
+        // Give the cache of the calling thread back to upstream.
+
+    thread_caching_stats stats() const;
+        // Return the allocation counts of all threads so far.
+
+    std::pmr::memory_resource *upstream_resource() const
+    {
+        return m_upstream_;
+    }
+
+private:
+    bool is_cached(size_t bytes, size_t alignment) const
+    {
+        return bytes <= m_options_.max_block &&
+               alignment <= alignof(std::max_align_t);
+    }
+
+    static int size_class(size_t bytes)
+    {
+        int index = 0;
+        for (size_t size = smallest_class; size < bytes; size *= 2) {
+            ++index;
+        }
+        return index;
+    }
+
+    cache *thread_cache();
+        // Return the cache of the calling thread, created on first use, or
+        // 'nullptr' if the thread is exiting.
+
+    void refill(magazine *bin, int index);
+        // Take a batch of blocks of the specified size class 'index' from
+        // upstream into the specified 'bin'.
+
+    void give_back(magazine *bin, int index, size_t count);
+        // Deallocate the specified 'count' blocks of the specified 'bin' of
+        // size class 'index' upstream.
+
+    void retire(cache *each);
+        // Give back all the blocks of the specified 'each' cache, add its
+        // counts to the totals, and unlink it.  The behavior is undefined
+        // unless 's_lock_' is held.
+
+    [[nodiscard]] void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const memory_resource& that) const noexcept override
+    {
+        return this == &that;
+    }
+};
+
+inline
+thread_caching_resource::thread_caching_resource(
+                                    thread_caching_options     options,
+                                    std::pmr::memory_resource *upstream)
+: m_upstream_(upstream)
+, m_options_(options)
+, m_serial_(s_next_serial_.fetch_add(1, std::memory_order_relaxed))
+{
+    m_options_.max_block = std::min(m_options_.max_block,
+                                    smallest_class << (max_classes - 1));
+    m_options_.batch     = std::max<size_t>(m_options_.batch, 1);
+}
+
+inline
+thread_caching_resource::~thread_caching_resource()
+{
+    std::lock_guard<std::mutex> guard{ s_lock_ };
+
+    // The caches stay allocated, orphaned, until their threads exit.
+
+    while (m_caches_) {
+        cache *each = m_caches_;
+        retire(each);
+        each->m_resource_ = nullptr;
+    }
+}
+
+inline
+thread_caching_resource::thread_caches::~thread_caches()
+{
+    s_exited_ = true;
+    s_hint_   = { 0, nullptr };
+
+    std::lock_guard<std::mutex> guard{ s_lock_ };
+
+    while (m_first_) {
+        cache *each = m_first_;
+        m_first_ = each->m_next_in_thread_;
+        if (each->m_resource_) {
+            each->m_resource_->retire(each);
+        }
+        delete each;
+    }
+}
+
+inline
+void thread_caching_resource::retire(cache *each)
+{
+    for (int index = 0; index < max_classes; ++index) {
+        magazine *bin = each->m_magazines_ + index;
+        give_back(bin, index, bin->m_count_);
+    }
+    m_hits_   += each->m_hits_.load(std::memory_order_relaxed);
+    m_misses_ += each->m_misses_.load(std::memory_order_relaxed);
+
+    cache **link = &m_caches_;
+    while (*link != each) {
+        link = &(*link)->m_next_in_resource_;
+    }
+    *link = each->m_next_in_resource_;
+}
+
+inline
+void thread_caching_resource::flush()
+{
+    std::lock_guard<std::mutex> guard{ s_lock_ };
+
+    for (cache *each = s_caches_.m_first_; each;
+                                            each = each->m_next_in_thread_) {
+        if (this == each->m_resource_) {
+            for (int index = 0; index < max_classes; ++index) {
+                magazine *bin = each->m_magazines_ + index;
+                give_back(bin, index, bin->m_count_);
+            }
+        }
+    }
+}
+
+inline
+thread_caching_stats thread_caching_resource::stats() const
+{
+    std::lock_guard<std::mutex> guard{ s_lock_ };
+
+    thread_caching_stats result{ m_hits_, m_misses_,
+                                 m_bypassed_.load(std::memory_order_relaxed) };
+    for (cache *each = m_caches_; each; each = each->m_next_in_resource_) {
+        result.hits   += each->m_hits_.load(std::memory_order_relaxed);
+        result.misses += each->m_misses_.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+inline
+thread_caching_resource::cache *thread_caching_resource::thread_cache()
+{
+    if (s_hint_.m_serial_ == m_serial_) {
+        return s_hint_.m_cache_;                                      // RETURN
+    }
+    if (s_exited_) {
+        return nullptr;                                               // RETURN
+    }
+
+    std::lock_guard<std::mutex> guard{ s_lock_ };
+
+    // Free the caches of the destroyed resources on the way.
+
+    cache  *found = nullptr;
+    cache **link  = &s_caches_.m_first_;
+    while (*link) {
+        cache *each = *link;
+        if (!each->m_resource_) {
+            *link = each->m_next_in_thread_;
+            delete each;
+            continue;
+        }
+        if (this == each->m_resource_) {
+            found = each;
+        }
+        link = &each->m_next_in_thread_;
+    }
+
+    if (!found) {
+        found = new cache{ this, m_caches_, s_caches_.m_first_,
+                           { 0 }, { 0 }, {} };
+        m_caches_          = found;
+        s_caches_.m_first_ = found;
+    }
+
+    s_hint_ = { m_serial_, found };
+    return found;
+}
+
+inline
+void thread_caching_resource::refill(magazine *bin, int index)
+{
+    const size_t size = smallest_class << index;
+    for (size_t i = 0; i < m_options_.batch; ++i) {
+        free_block *block;
+        try {
+            block = static_cast<free_block *>(
+                  m_upstream_->allocate(size, alignof(std::max_align_t)));
+        }
+        catch (...) {
+            if (bin->m_free_) {
+                return;                                               // RETURN
+            }
+            throw;
+        }
+        block->m_next_ = bin->m_free_;
+        bin->m_free_   = block;
+        ++bin->m_count_;
+    }
+}
+
+inline
+void thread_caching_resource::give_back(magazine *bin,
+                                        int       index,
+                                        size_t    count)
+{
+    const size_t size = smallest_class << index;
+    for (size_t i = 0; i < count; ++i) {
+        free_block *block = bin->m_free_;
+        bin->m_free_ = block->m_next_;
+        m_upstream_->deallocate(block, size, alignof(std::max_align_t));
+    }
+    bin->m_count_ -= count;
+}
+
+inline
+void *thread_caching_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (!is_cached(bytes, alignment)) {
+        m_bypassed_.fetch_add(1, std::memory_order_relaxed);
+        return m_upstream_->allocate(bytes, alignment);               // RETURN
+    }
+
+    const int  index = size_class(bytes);
+    cache     *mine  = thread_cache();
+    if (!mine) {
+        // Allocate as a cached block would be, since it is deallocated so.
+
+        m_bypassed_.fetch_add(1, std::memory_order_relaxed);
+        return m_upstream_->allocate(smallest_class << index,
+                                     alignof(std::max_align_t));      // RETURN
+    }
+
+    magazine  *bin   = mine->m_magazines_ + index;
+    if (bin->m_free_) {
+        mine->m_hits_.store(mine->m_hits_.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+    }
+    else {
+        refill(bin, index);
+        mine->m_misses_.store(
+                          mine->m_misses_.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+    }
+
+    free_block *result = bin->m_free_;
+    bin->m_free_ = result->m_next_;
+    --bin->m_count_;
+    return result;
+}
+
+inline
+void thread_caching_resource::do_deallocate(void   *p,
+                                            size_t  bytes,
+                                            size_t  alignment)
+{
+    if (!is_cached(bytes, alignment)) {
+        m_upstream_->deallocate(p, bytes, alignment);
+        return;                                                       // RETURN
+    }
+
+    const int  index = size_class(bytes);
+    cache     *mine  = thread_cache();
+    if (!mine) {
+        m_upstream_->deallocate(p,
+                                smallest_class << index,
+                                alignof(std::max_align_t));
+        return;                                                       // RETURN
+    }
+
+    magazine   *bin   = mine->m_magazines_ + index;
+    free_block *freed = static_cast<free_block *>(p);
+    freed->m_next_ = bin->m_free_;
+    bin->m_free_   = freed;
+    if (++bin->m_count_ >= 2 * m_options_.batch) {
+        give_back(bin, index, m_options_.batch);
+    }
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------
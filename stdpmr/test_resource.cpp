@@ -2,11 +2,21 @@
 #include <memory_resource_p1160>
 
 #include <algorithm>  // for min
+#include <chrono>     // steady_clock
 #include <cassert>    // for assert
 #include <cstdio>     // print messages
 #include <cstddef>    // byte
+#include <cstdint>    // uintptr_t
 #include <cstdlib>    // abort
 #include <cstring>    // memset
+#include <thread>     // this_thread::get_id
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h> // backtrace
+#define P1160_HAS_BACKTRACE 1
+#endif
+#endif
 
 namespace std::pmr {
 
@@ -28,13 +38,81 @@ static const byte paddedMemoryByte{ 0xB1 };     // byte used to write over
 static const size_t paddingSize = alignof(max_align_t);
     // size of the padding before and after the user segment
 
+static const unsigned maxTags = 64;
+    // number of phase tags, including "untagged" (0) and the overflow tag
+
+static const unsigned overflowTag = maxTags - 1;
+    // tag shared by all labels registered beyond the limit
+
+static const size_t maxTagLength = 31;
+    // longest label kept by the tag registry, longer labels are truncated
+
+static const int maxTagDepth = 32;
+    // number of nested tag scopes tracked per thread
+
+struct TagRegistry {
+    // This 'struct' maps phase tag labels to their identifiers.
+
+    mutex    m_lock_;                                  // guards the table
+    unsigned m_count_{ 1 };                            // tags in use
+    char     m_labels_[maxTags][maxTagLength + 1]{};   // the labels
+};
+
+static TagRegistry& tagRegistry()
+    // Return the process-wide tag registry.
+{
+    static TagRegistry instance;
+    return instance;
+}
+
+thread_local unsigned short tagStack[maxTagDepth];
+    // tags of the tag scopes of the current thread, innermost last
+
+thread_local int tagDepth{ 0 };
+    // nesting depth of the tag scopes of the current thread, may exceed
+    // 'maxTagDepth' in which case the deepest scopes are not recorded
+
+static atomic<unsigned long long> nextResourceSerial{ 1 };
+    // serial number handed to the next 'test_resource' constructed, used to
+    // tell apart resources that reuse the address of a destroyed one
+
+struct StackTrace {
+    // This 'struct' holds the call stack captured for one allocation.
+
+    int   m_depth_;                               // number of frames
+    void *m_frames_[test_resource_max_frames];    // return addresses
+};
+
+struct PeakRecord;
+
 struct Link {
     // This 'struct' holds pointers to the next and preceding allocated
     // memory block in the allocated memory block list.
 
-    long long  m_index_;  // index of this allocation
-    Link      *m_next_;   // next 'Link' pointer
-    Link      *m_prev_;   // previous 'Link' pointer
+    long long   m_index_;  // index of this allocation
+    Link       *m_next_;   // next 'Link' pointer
+    Link       *m_prev_;   // previous 'Link' pointer
+    size_t      m_bytes_;  // size of the allocated block
+    unsigned    m_tag_;    // phase tag of the allocated block
+    StackTrace *m_stack_;  // call stack of the allocation, or 'nullptr'
+    PeakRecord *m_peak_;   // entry in the peak snapshot, or 'nullptr'
+    unsigned long long
+                m_site_;   // growth site of the allocation, or 0
+};
+
+struct PeakRecord {
+    // This 'struct' describes a block that was live when the peak snapshot
+    // was last taken.  It outlives the block if the block is freed, until
+    // the next peak replaces the snapshot.
+
+    long long   m_index_;       // index of the allocation
+    size_t      m_bytes_;       // size of the block
+    unsigned    m_tag_;         // phase tag of the block
+    StackTrace *m_stack_;       // call stack, shared with 'm_link_' if live
+    Link       *m_link_;        // link of the block, 'nullptr' once freed
+    PeakRecord *m_next_;        // next record in the snapshot
+    PeakRecord *m_prev_;        // previous record in the snapshot
+    PeakRecord *m_next_freed_;  // next record whose block has been freed
 };
 
 struct alignas(std::max_align_t) Padding {
@@ -58,6 +136,11 @@ struct Header {
 
     void         *m_pmr_;           // address of current PMR
 
+    test_resource_thread_record
+                 *m_thread_;        // statistics of the allocating thread
+
+    unsigned      m_tag_;           // phase tag in effect at allocation
+
     Padding       m_padding_;       // padding -- guaranteed to extend to the
                                     // end of the struct
 };
@@ -71,6 +154,744 @@ union AlignedHeader {
 
 }  // close unnamed namespace
 
+struct test_resource_thread_record {
+    // This 'struct' holds the allocation statistics attributed to one thread
+    // that allocated from a 'test_resource'.
+
+    thread::id                   m_thread_id_;   // the allocating thread
+    unsigned long long           m_thread_key_;  // unique to that thread
+    long long                    m_ordinal_;     // order of first allocation
+    test_resource_usage          m_usage_;       // attributed counters
+    long long                    m_cross_thread_deallocations_;
+                                                 // blocks freed by others
+    test_resource_thread_record *m_next_;        // next record in the list
+};
+
+struct test_resource_list {
+    // This 'struct' stores a head 'Link' and a tail 'Link' for list
+    // manipulation.
+
+    Link *d_head_p;  // address of first link in list (or 'nullptr')
+    Link *d_tail_p;  // address of last link in list (or 'nullptr')
+};
+
+struct test_resource_peak {
+    // This 'struct' holds the snapshot of the blocks live at the peak.  The
+    // snapshot is maintained incrementally: when a new peak is reached only
+    // the blocks freed, and those allocated, since the previous peak are
+    // visited, so the amortized cost is constant per allocation.
+
+    PeakRecord *m_head_;        // first record, in allocation order
+    PeakRecord *m_tail_;        // last record
+    PeakRecord *m_freed_;       // records whose block was freed since
+    long long   m_last_index_;  // index of the last allocation at the peak
+    long long   m_bytes_;       // bytes in use at the peak
+    long long   m_blocks_;      // blocks in use at the peak
+    bool        m_resized_;     // a block of the snapshot has been resized
+};
+
+struct TimelineSample {
+    // This 'struct' holds one sample of the usage time series.
+
+    long long m_event_;        // allocations and deallocations so far
+    long long m_allocations_;  // allocations so far
+    long long m_nanoseconds_;  // time since recording started
+    long long m_bytes_;        // bytes in use
+    long long m_blocks_;       // blocks in use
+    long long m_max_bytes_;    // highest bytes in use since previous sample
+};
+
+struct test_resource_timeline {
+    // This 'struct' holds the usage time series, followed in memory by its
+    // array of 'm_capacity_' samples.
+
+    size_t                   m_capacity_;      // maximum number of samples
+    size_t                   m_size_;          // number of samples
+    long long                m_stride_;        // events per sample
+    long long                m_events_;        // events recorded
+    long long                m_interval_max_;  // highest bytes in use since
+                                               // the previous sample
+    chrono::steady_clock::time_point
+                             m_start_;         // time recording started
+
+    TimelineSample *samples()
+    {
+        return reinterpret_cast<TimelineSample *>(this + 1);
+    }
+
+    const TimelineSample *samples() const
+    {
+        return reinterpret_cast<const TimelineSample *>(this + 1);
+    }
+};
+
+static const int maxGrowthSites = 256;
+    // number of sites the growth analyzer can follow
+
+static const long long growthWindow = 4;
+    // maximum number of allocations between the allocation of the larger
+    // block and the deallocation of the smaller one for a growth step
+
+struct GrowthSite {
+    // This 'struct' holds the state of the growth analyzer for one site.
+
+    unsigned long long m_key_;            // site key, 0 if the slot is free
+    unsigned           m_tag_;            // phase tag of the site
+    StackTrace        *m_stack_;          // call stack of the site, if any
+    long long          m_last_index_;     // latest allocation at the site
+    size_t             m_last_bytes_;     // size of the latest allocation
+    long long          m_grown_index_;    // latest block that replaced a
+                                          // smaller one
+    long long          m_chain_;          // current consecutive steps
+    long long          m_longest_chain_;  // most consecutive steps
+    long long          m_reallocations_;  // growth steps
+    long long          m_bytes_copied_;   // size of replaced blocks
+    size_t             m_largest_bytes_;  // largest allocation at the site
+};
+
+struct test_resource_growth {
+    // This 'struct' holds the sites followed by the growth analyzer in an
+    // open-addressing hash table.
+
+    long long  m_reallocations_;         // growth steps, all sites
+    long long  m_bytes_copied_;          // size of replaced blocks
+    GrowthSite m_sites_[maxGrowthSites];  // the table
+};
+
+namespace {
+
+struct ThreadRecordCache {
+    // This 'struct' caches, for the current thread, the statistics record it
+    // used most recently, so consecutive allocations from the same resource
+    // do not need to search the resource's list of threads.
+
+    unsigned long long           m_serial_;  // serial of owning resource
+    test_resource_thread_record *m_record_;  // the cached record
+};
+
+thread_local ThreadRecordCache threadRecordCache{ 0, nullptr };
+
+atomic<unsigned long long> nextThreadKey{ 1 };
+thread_local unsigned long long threadKey{ 0 };
+
+}  // close unnamed namespace
+
+static
+unsigned long long currentThreadKey()
+    // Return the key of the calling thread, unique for the life of the
+    // process, unlike 'thread::id', which a later thread may reuse once the
+    // thread has exited.
+{
+    if (0 == threadKey) {
+        threadKey = nextThreadKey.fetch_add(1, memory_order_relaxed);
+    }
+    return threadKey;
+}
+
+static
+test_resource_thread_record *findThreadRecord(
+                                   test_resource_thread_record **list,
+                                   unsigned long long            serial,
+                                   memory_resource              *pmrp)
+    // Return the statistics record of the calling thread from the specified
+    // 'list' of the resource having the specified 'serial' number, creating
+    // and appending a new record, using the specified 'pmrp' to supply
+    // memory, if the calling thread has none.  The behavior is undefined
+    // unless the lock of the resource owning the 'list' is held.
+{
+    if (threadRecordCache.m_serial_ == serial) {
+        return threadRecordCache.m_record_;                           // RETURN
+    }
+
+    const unsigned long long      key   = currentThreadKey();
+    test_resource_thread_record **next  = list;
+    long long                     count = 0;
+
+    while (*next && (*next)->m_thread_key_ != key) {
+        next = &(*next)->m_next_;
+        ++count;
+    }
+
+    if (!*next) {
+        *next = static_cast<test_resource_thread_record *>(
+                      pmrp->allocate(sizeof(test_resource_thread_record),
+                                     alignof(test_resource_thread_record)));
+        (*next)->m_thread_id_                  = this_thread::get_id();
+        (*next)->m_thread_key_                 = key;
+        (*next)->m_ordinal_                    = count;
+        (*next)->m_usage_                      = test_resource_usage{};
+        (*next)->m_cross_thread_deallocations_ = 0;
+        (*next)->m_next_                       = nullptr;
+    }
+
+    threadRecordCache.m_serial_ = serial;
+    threadRecordCache.m_record_ = *next;
+
+    return *next;
+}
+
+static
+void recordAllocation(test_resource_usage *usage, size_t bytes)
+    // Update the specified 'usage' to reflect the allocation of a block of
+    // the specified 'bytes'.
+{
+    ++usage->blocks_in_use;
+    ++usage->total_blocks;
+    usage->max_blocks = max(usage->max_blocks, usage->blocks_in_use);
+
+    usage->bytes_in_use += static_cast<long long>(bytes);
+    usage->total_bytes  += static_cast<long long>(bytes);
+    usage->max_bytes     = max(usage->max_bytes, usage->bytes_in_use);
+}
+
+static
+void recordDeallocation(test_resource_usage *usage, size_t bytes)
+    // Update the specified 'usage' to reflect the deallocation of a block of
+    // the specified 'bytes'.
+{
+    --usage->blocks_in_use;
+    usage->bytes_in_use -= static_cast<long long>(bytes);
+}
+
+static
+void recordResize(test_resource_usage *usage, size_t oldBytes, size_t newBytes)
+    // Update the specified 'usage' to reflect the resizing in place of a
+    // block of the specified 'oldBytes' to the specified 'newBytes'.  Growth
+    // counts towards the total, as if the extra bytes were allocated.
+{
+    usage->bytes_in_use += static_cast<long long>(newBytes) -
+                           static_cast<long long>(oldBytes);
+    if (oldBytes < newBytes) {
+        usage->total_bytes += static_cast<long long>(newBytes - oldBytes);
+    }
+    usage->max_bytes = max(usage->max_bytes, usage->bytes_in_use);
+}
+
+static
+StackTrace *captureStack(memory_resource *pmrp)
+    // Return the call stack of the caller, captured in memory supplied by
+    // the specified 'pmrp', or 'nullptr' if the platform cannot capture it.
+{
+#ifdef P1160_HAS_BACKTRACE
+    void *frames[test_resource_max_frames + 1];
+    int   depth = backtrace(frames, test_resource_max_frames + 1);
+    if (depth <= 1) {
+        return nullptr;                                               // RETURN
+    }
+
+    // Skip the frame of this function.
+
+    StackTrace *stack = static_cast<StackTrace *>(
+                     pmrp->allocate(sizeof(StackTrace), alignof(StackTrace)));
+    stack->m_depth_ = depth - 1;
+    copy(frames + 1, frames + depth, stack->m_frames_);
+    return stack;
+#else
+    (void)pmrp;
+    return nullptr;
+#endif
+}
+
+static
+void freeStack(StackTrace *stack, memory_resource *pmrp)
+    // Return the specified 'stack', if any, to the specified 'pmrp'.
+{
+    if (stack) {
+        pmrp->deallocate(stack, sizeof(StackTrace), alignof(StackTrace));
+    }
+}
+
+static
+void appendPeakRecord(test_resource_peak *peak,
+                      Link               *link,
+                      memory_resource    *pmrp)
+    // Append to the specified 'peak' snapshot a record of the block of the
+    // specified 'link', using the specified 'pmrp' to supply memory.
+{
+    PeakRecord *record = static_cast<PeakRecord *>(
+                     pmrp->allocate(sizeof(PeakRecord), alignof(PeakRecord)));
+
+    record->m_index_      = link->m_index_;
+    record->m_bytes_      = link->m_bytes_;
+    record->m_tag_        = link->m_tag_;
+    record->m_stack_      = link->m_stack_;
+    record->m_link_       = link;
+    record->m_next_       = nullptr;
+    record->m_prev_       = peak->m_tail_;
+    record->m_next_freed_ = nullptr;
+
+    if (peak->m_tail_) {
+        peak->m_tail_->m_next_ = record;
+    }
+    else {
+        peak->m_head_ = record;
+    }
+    peak->m_tail_ = record;
+    link->m_peak_ = record;
+}
+
+static
+void freePeakRecord(PeakRecord *record, memory_resource *pmrp)
+    // Return the specified 'record' to the specified 'pmrp'.  The call stack
+    // belongs to the record only if the block has already been freed.
+{
+    if (record->m_link_) {
+        record->m_link_->m_peak_ = nullptr;
+    }
+    else {
+        freeStack(record->m_stack_, pmrp);
+    }
+    pmrp->deallocate(record, sizeof(PeakRecord), alignof(PeakRecord));
+}
+
+static
+void updatePeak(test_resource_peak       *peak,
+                const test_resource_list& list,
+                long long                 bytes,
+                long long                 blocks,
+                long long                 lastIndex,
+                memory_resource          *pmrp)
+    // Update the specified 'peak' snapshot to hold the blocks of the
+    // specified 'list', the live blocks when a new peak of the specified
+    // 'bytes' and 'blocks' in use is reached by the allocation of the
+    // specified 'lastIndex', using the specified 'pmrp' to supply memory.
+{
+    // Drop the blocks freed since the previous peak.
+
+    while (peak->m_freed_) {
+        PeakRecord *record = peak->m_freed_;
+        peak->m_freed_ = record->m_next_freed_;
+
+        if (record->m_prev_) {
+            record->m_prev_->m_next_ = record->m_next_;
+        }
+        else {
+            peak->m_head_ = record->m_next_;
+        }
+        if (record->m_next_) {
+            record->m_next_->m_prev_ = record->m_prev_;
+        }
+        else {
+            peak->m_tail_ = record->m_prev_;
+        }
+        freePeakRecord(record, pmrp);
+    }
+
+    // Add the live blocks allocated since the previous peak.  The list is in
+    // allocation order, so they are all at its tail.
+
+    Link *first = nullptr;
+    for (Link *link = list.d_tail_p;
+         link && link->m_index_ > peak->m_last_index_;
+         link = link->m_prev_) {
+        first = link;
+    }
+    for (; first; first = first->m_next_) {
+        appendPeakRecord(peak, first, pmrp);
+    }
+
+    // Blocks resized in place since the previous peak have a new size.
+    // Resizing is rare, so visiting the whole snapshot then is affordable.
+
+    if (peak->m_resized_) {
+        for (PeakRecord *record = peak->m_head_;
+             record;
+             record = record->m_next_) {
+            if (record->m_link_) {
+                record->m_bytes_ = record->m_link_->m_bytes_;
+            }
+        }
+        peak->m_resized_ = false;
+    }
+
+    peak->m_last_index_ = lastIndex;
+    peak->m_bytes_      = bytes;
+    peak->m_blocks_     = blocks;
+}
+
+static
+void destroyPeak(test_resource_peak *peak, memory_resource *pmrp)
+    // Free the specified 'peak' snapshot and all its records, using the
+    // specified 'pmrp' that supplied their memory.
+{
+    while (peak->m_head_) {
+        PeakRecord *record = peak->m_head_;
+        peak->m_head_ = record->m_next_;
+        freePeakRecord(record, pmrp);
+    }
+    pmrp->deallocate(peak,
+                     sizeof(test_resource_peak),
+                     alignof(test_resource_peak));
+}
+
+static
+void printPeak(const test_resource_peak& peak)
+    // Print the blocks of the specified 'peak' snapshot.
+{
+    printf(" Live Blocks At Peak (%lld blocks, %lld bytes):\n"
+           "           Index\tBytes\tTag\n"
+           "           -----\t-----\t---\n",
+           peak.m_blocks_, peak.m_bytes_);
+
+    for (const PeakRecord *record = peak.m_head_;
+         record;
+         record = record->m_next_) {
+        string_view label = test_resource_tag_name(record->m_tag_);
+        printf("%16lld\t%zu\t%.*s\n",
+               record->m_index_,
+               record->m_bytes_,
+               static_cast<int>(label.length()), label.data());
+
+        if (record->m_stack_) {
+            printf("                \tat");
+            for (int i = 0; i < record->m_stack_->m_depth_; ++i) {
+                printf(" %p", record->m_stack_->m_frames_[i]);
+            }
+            printf("\n");
+        }
+    }
+    printf("--------------------------------------------------\n");
+}
+
+static
+void recordTimelineEvent(test_resource_timeline *timeline,
+                         long long               allocations,
+                         long long               bytes,
+                         long long               blocks)
+    // Record in the specified 'timeline' an event after which there were the
+    // specified 'allocations' in total, and 'bytes' and 'blocks' in use.
+{
+    ++timeline->m_events_;
+    timeline->m_interval_max_ = max(timeline->m_interval_max_, bytes);
+
+    if (0 != timeline->m_events_ % timeline->m_stride_) {
+        return;                                                       // RETURN
+    }
+
+    TimelineSample *samples = timeline->samples();
+
+    if (timeline->m_size_ == timeline->m_capacity_) {
+        // Halve the resolution: merge adjacent samples, keeping the later
+        // values and the higher peak.
+
+        for (size_t i = 0; i < timeline->m_size_ / 2; ++i) {
+            TimelineSample merged = samples[2 * i + 1];
+            merged.m_max_bytes_   = max(samples[2 * i].m_max_bytes_,
+                                        samples[2 * i + 1].m_max_bytes_);
+            samples[i] = merged;
+        }
+        if (timeline->m_size_ % 2) {
+            samples[timeline->m_size_ / 2] = samples[timeline->m_size_ - 1];
+        }
+        timeline->m_size_   = (timeline->m_size_ + 1) / 2;
+        timeline->m_stride_ *= 2;
+
+        if (0 != timeline->m_events_ % timeline->m_stride_) {
+            return;                                                   // RETURN
+        }
+    }
+
+    samples[timeline->m_size_++] = {
+        timeline->m_events_,
+        allocations,
+        chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now() - timeline->m_start_).count(),
+        bytes,
+        blocks,
+        timeline->m_interval_max_
+    };
+    timeline->m_interval_max_ = bytes;
+}
+
+static
+void destroyTimeline(test_resource_timeline *timeline, memory_resource *pmrp)
+    // Free the specified 'timeline', using the specified 'pmrp' that supplied
+    // its memory.
+{
+    pmrp->deallocate(timeline,
+                     sizeof(test_resource_timeline) +
+                               timeline->m_capacity_ * sizeof(TimelineSample),
+                     alignof(test_resource_timeline));
+}
+
+static
+unsigned long long growthSiteKey(const Link& link)
+    // Return the growth site key of the block of the specified 'link': its
+    // call stack if captured, and its phase tag otherwise.  Never 0.
+{
+    unsigned long long key = 1469598103934665603ULL;  // FNV-1a
+    const auto         mix = [&key](unsigned long long value) {
+        key = (key ^ value) * 1099511628211ULL;
+    };
+
+    mix(link.m_tag_);
+    if (link.m_stack_) {
+        for (int i = 0; i < link.m_stack_->m_depth_; ++i) {
+            mix(reinterpret_cast<uintptr_t>(link.m_stack_->m_frames_[i]));
+        }
+    }
+    return key ? key : 1;
+}
+
+static
+GrowthSite *findGrowthSite(test_resource_growth *growth,
+                           unsigned long long    key,
+                           bool                  insert)
+    // Return the site having the specified 'key' in the specified 'growth'
+    // table, adding it if the specified 'insert' is 'true'.  Return
+    // 'nullptr' if not found, or if the table is full.
+{
+    for (int probe = 0; probe < maxGrowthSites; ++probe) {
+        GrowthSite *site = growth->m_sites_ +
+                                         (key + probe) % maxGrowthSites;
+        if (key == site->m_key_) {
+            return site;                                              // RETURN
+        }
+        if (0 == site->m_key_) {
+            if (!insert) {
+                return nullptr;                                       // RETURN
+            }
+            *site = GrowthSite{};
+            site->m_key_         = key;
+            site->m_last_index_  = -1;
+            site->m_grown_index_ = -1;
+            return site;                                              // RETURN
+        }
+    }
+    return nullptr;
+}
+
+static
+GrowthSite *prepareGrowthSite(test_resource_growth *growth,
+                              Link                 *link,
+                              memory_resource      *pmrp)
+    // Return the site of the block of the specified 'link' in the specified
+    // 'growth' analyzer, adding it, and copying the call stack of its first
+    // block in memory supplied by the specified 'pmrp', if it is new.
+    // Return 'nullptr' if the table is full.
+{
+    link->m_site_ = growthSiteKey(*link);
+
+    GrowthSite *site = findGrowthSite(growth, link->m_site_, true);
+    if (site && !site->m_stack_ && 0 == site->m_largest_bytes_) {
+        site->m_tag_ = link->m_tag_;
+        if (link->m_stack_) {
+            site->m_stack_  = static_cast<StackTrace *>(
+                     pmrp->allocate(sizeof(StackTrace), alignof(StackTrace)));
+            *site->m_stack_ = *link->m_stack_;
+        }
+    }
+    return site;
+}
+
+static
+void recordGrowthAllocation(GrowthSite *site, const Link *link)
+    // Record in the specified 'site', if any, the allocation of the block of
+    // the specified 'link'.
+{
+    if (!site) {
+        return;                                                       // RETURN
+    }
+
+    site->m_last_index_    = link->m_index_;
+    site->m_last_bytes_    = link->m_bytes_;
+    site->m_largest_bytes_ = max(site->m_largest_bytes_, link->m_bytes_);
+}
+
+static
+void recordGrowthDeallocation(test_resource_growth *growth,
+                              const Link&           link,
+                              long long             allocations)
+    // Record in the specified 'growth' analyzer the deallocation of the
+    // block of the specified 'link', after the specified 'allocations' in
+    // total.
+{
+    if (0 == link.m_site_) {
+        return;                                                       // RETURN
+    }
+
+    GrowthSite *site = findGrowthSite(growth, link.m_site_, false);
+    if (!site) {
+        return;                                                       // RETURN
+    }
+
+    // A smaller block freed shortly after a larger block was allocated from
+    // the same site: its contents were (most likely) copied into the larger
+    // block, which a 'reserve' would have avoided.
+
+    if (site->m_last_index_ > link.m_index_ &&
+        site->m_last_bytes_ > link.m_bytes_ &&
+        allocations - 1 - site->m_last_index_ <= growthWindow) {
+        site->m_chain_ = site->m_grown_index_ == link.m_index_
+                       ? site->m_chain_ + 1
+                       : 1;
+        site->m_longest_chain_ = max(site->m_longest_chain_, site->m_chain_);
+        site->m_grown_index_   = site->m_last_index_;
+
+        ++site->m_reallocations_;
+        site->m_bytes_copied_ += static_cast<long long>(link.m_bytes_);
+
+        ++growth->m_reallocations_;
+        growth->m_bytes_copied_ += static_cast<long long>(link.m_bytes_);
+    }
+}
+
+static
+void destroyGrowth(test_resource_growth *growth, memory_resource *pmrp)
+    // Free the specified 'growth' analyzer, using the specified 'pmrp' that
+    // supplied its memory.
+{
+    for (const GrowthSite& site : growth->m_sites_) {
+        if (site.m_key_) {
+            freeStack(site.m_stack_, pmrp);
+        }
+    }
+    pmrp->deallocate(growth,
+                     sizeof(test_resource_growth),
+                     alignof(test_resource_growth));
+}
+
+static
+int sortedGrowthSites(const test_resource_growth&  growth,
+                      const GrowthSite            **sites)
+    // Load into the specified 'sites' array, of at least 'maxGrowthSites'
+    // elements, the sites of the specified 'growth' analyzer having growth
+    // steps, most bytes copied first.  Return the number of sites loaded.
+{
+    int count = 0;
+    for (const GrowthSite& site : growth.m_sites_) {
+        if (site.m_key_ && site.m_reallocations_) {
+            sites[count++] = &site;
+        }
+    }
+    sort(sites, sites + count, [](const GrowthSite *a, const GrowthSite *b) {
+        return a->m_bytes_copied_ > b->m_bytes_copied_;
+    });
+    return count;
+}
+
+static
+void printGrowth(const test_resource_growth& growth)
+    // Print the sites of the specified 'growth' analyzer having growth steps.
+{
+    const GrowthSite *sites[maxGrowthSites];
+    const int         count = sortedGrowthSites(growth, sites);
+
+    printf(" Growth Reallocations (%lld steps, %lld bytes copied):\n"
+           "             Tag\tSteps\tCopied\tChain\tLargest\n"
+           "             ---\t-----\t------\t-----\t-------\n",
+           growth.m_reallocations_, growth.m_bytes_copied_);
+
+    for (int i = 0; i < count; ++i) {
+        string_view label = 0 == sites[i]->m_tag_
+                          ? string_view("(untagged)")
+                          : test_resource_tag_name(sites[i]->m_tag_);
+        printf("%16.*s\t%lld\t%lld\t%lld\t%zu\n",
+               static_cast<int>(label.length()), label.data(),
+               sites[i]->m_reallocations_,
+               sites[i]->m_bytes_copied_,
+               sites[i]->m_longest_chain_,
+               sites[i]->m_largest_bytes_);
+
+        if (sites[i]->m_stack_) {
+            printf("                \tat");
+            for (int j = 0; j < sites[i]->m_stack_->m_depth_; ++j) {
+                printf(" %p", sites[i]->m_stack_->m_frames_[j]);
+            }
+            printf("\n");
+        }
+    }
+    printf("--------------------------------------------------\n");
+}
+
+static
+void printTagUsage(const test_resource_usage *tags, bool inUseOnly)
+    // Print the usage of each tag in the specified 'tags' table that was ever
+    // used, or only those having blocks in use if the specified 'inUseOnly'
+    // is 'true'.
+{
+    printf(" Per-Tag Usage (bytes):\n"
+           "             Tag\tBlocks\tIn Use\tMax\tTotal\n"
+           "             ---\t------\t------\t---\t-----\n");
+
+    for (unsigned tag = 0; tag < maxTags; ++tag) {
+        const test_resource_usage& usage = tags[tag];
+        if (0 == usage.total_blocks || (inUseOnly && !usage.blocks_in_use)) {
+            continue;                                               // CONTINUE
+        }
+        string_view label = 0 == tag ? string_view("(untagged)")
+                                     : test_resource_tag_name(tag);
+        printf("%16.*s\t%lld\t%lld\t%lld\t%lld\n",
+               static_cast<int>(label.length()), label.data(),
+               usage.blocks_in_use,
+               usage.bytes_in_use,
+               usage.max_bytes,
+               usage.total_bytes);
+    }
+    printf("--------------------------------------------------\n");
+}
+
+unsigned test_resource_tag_id(string_view label) noexcept
+{
+    if (label.empty()) {
+        return 0;                                                     // RETURN
+    }
+
+    label = label.substr(0, maxTagLength);
+
+    TagRegistry& registry = tagRegistry();
+    lock_guard   guard{ registry.m_lock_ };
+
+    for (unsigned tag = 1; tag < registry.m_count_; ++tag) {
+        if (label == registry.m_labels_[tag]) {
+            return tag;                                               // RETURN
+        }
+    }
+
+    if (overflowTag == registry.m_count_) {
+        return overflowTag;                                           // RETURN
+    }
+
+    label.copy(registry.m_labels_[registry.m_count_], label.length());
+    return registry.m_count_++;
+}
+
+string_view test_resource_tag_name(unsigned id) noexcept
+{
+    if (overflowTag == id) {
+        return "(overflow)";                                          // RETURN
+    }
+
+    TagRegistry& registry = tagRegistry();
+    lock_guard   guard{ registry.m_lock_ };
+
+    return 0 < id && id < registry.m_count_ ? registry.m_labels_[id] : "";
+}
+
+unsigned test_resource_current_tag() noexcept
+{
+    return 0 == tagDepth ? 0 : tagStack[min(tagDepth, maxTagDepth) - 1];
+}
+
+test_resource_tag_scope::test_resource_tag_scope(unsigned tag) noexcept
+{
+    if (tagDepth < maxTagDepth) {
+        tagStack[tagDepth] = static_cast<unsigned short>(
+                                                      min(tag, overflowTag));
+    }
+    ++tagDepth;
+}
+
+test_resource_tag_scope::test_resource_tag_scope(string_view label) noexcept
+: test_resource_tag_scope(test_resource_tag_id(label))
+{
+}
+
+test_resource_tag_scope::~test_resource_tag_scope()
+{
+    --tagDepth;
+}
+
 static
 void formatBlock(void *address, std::size_t length)
     // Format in hex to 'stdout', a block of memory starting at the specified
@@ -202,14 +1023,6 @@ void formatBadBytesForNullptr(size_t         deallocatedBytes,
            "(%zu). ***\n", deallocatedBytes, deallocatedAlignment);
 }
 
-struct test_resource_list {
-    // This 'struct' stores a head 'Link' and a tail 'Link' for list
-    // manipulation.
-
-    Link *d_head_p;  // address of first link in list (or 'nullptr')
-    Link *d_tail_p;  // address of last link in list (or 'nullptr')
-};
-
 static
 Link *removeLink(test_resource_list *list, Link *link)
     // Remove the specified 'link' from the specified 'allocatedList'.  Return
@@ -253,6 +1066,11 @@ Link *addLink(test_resource_list *list,
 
     link->m_next_ = nullptr;
     link->m_index_  = index;
+    link->m_bytes_  = 0;
+    link->m_tag_    = 0;
+    link->m_stack_  = nullptr;
+    link->m_peak_   = nullptr;
+    link->m_site_   = 0;
 
     if (!list->d_head_p) {
         list->d_head_p = link;
@@ -268,6 +1086,25 @@ Link *addLink(test_resource_list *list,
     return link;
 }
 
+static
+void printThreadUsage(const test_resource_thread_record *list)
+    // Print the usage attributed to each thread in the specified 'list'.
+{
+    printf(" Per-Thread Usage (bytes):\n"
+           "          Thread\tIn Use\tMax\tTotal\tX-Frees\n"
+           "          ------\t------\t---\t-----\t-------\n");
+
+    for (; list; list = list->m_next_) {
+        printf("%16lld\t%lld\t%lld\t%lld\t%lld\n",
+               list->m_ordinal_,
+               list->m_usage_.bytes_in_use,
+               list->m_usage_.max_bytes,
+               list->m_usage_.total_bytes,
+               list->m_cross_thread_deallocations_);
+    }
+    printf("--------------------------------------------------\n");
+}
+
 static
 void printList(const test_resource_list& list)
     // Print the indices of all 'Link' objects currently in the specified
@@ -382,6 +1219,8 @@ test_resource::test_resource(string_view      name,
 , m_verbose_flag_(verbose)
 , m_pmr_(pmrp)
 {
+    m_serial_ = nextResourceSerial.fetch_add(1, memory_order_relaxed);
+
     m_list_ = (test_resource_list *)m_pmr_->allocate(
                                                    sizeof(test_resource_list));
     m_list_->d_head_p = nullptr;
@@ -401,10 +1240,26 @@ test_resource::~test_resource()
         print();
     }
 
+    if (m_peak_) {
+        destroyPeak(m_peak_, m_pmr_);
+        m_peak_ = nullptr;
+    }
+
+    if (m_timeline_) {
+        destroyTimeline(m_timeline_, m_pmr_);
+        m_timeline_ = nullptr;
+    }
+
+    if (m_growth_) {
+        destroyGrowth(m_growth_, m_pmr_);
+        m_growth_ = nullptr;
+    }
+
     Link *link_p = m_list_->d_head_p;
     while (link_p) {
         Link *linkToFree = link_p;
         link_p = link_p->m_next_;
+        freeStack(linkToFree->m_stack_, m_pmr_);
         m_pmr_->deallocate(linkToFree, sizeof(Link), alignof(Link));
     }
     m_list_->d_head_p = nullptr;
@@ -413,6 +1268,14 @@ test_resource::~test_resource()
                        sizeof(test_resource_list),
                        alignof(test_resource_list));
 
+    while (m_threads_) {
+        test_resource_thread_record *recordToFree = m_threads_;
+        m_threads_ = m_threads_->m_next_;
+        m_pmr_->deallocate(recordToFree,
+                           sizeof(test_resource_thread_record),
+                           alignof(test_resource_thread_record));
+    }
+
     if (!is_quiet()) {
         if (bytes_in_use() || blocks_in_use()) {
             printf("MEMORY_LEAK");
@@ -423,12 +1286,21 @@ test_resource::~test_resource()
             printf(":\n  Number of blocks in use = %lld\n"
                    "   Number of bytes in use = %lld\n",
                    blocks_in_use(), bytes_in_use());
+            if (m_tags_) {
+                printTagUsage(m_tags_, true);
+            }
 
             if (!is_no_abort()) {
                 std::abort();                                          // ABORT
             }
         }
     }
+
+    if (m_tags_) {
+        m_pmr_->deallocate(m_tags_,
+                           maxTags * sizeof(test_resource_usage),
+                           alignof(test_resource_usage));
+    }
 }
 
 void *test_resource::do_allocate(size_t bytes, size_t alignment)
@@ -443,17 +1315,70 @@ void *test_resource::do_allocate(size_t bytes, size_t alignment)
         throw bad_alloc();
     }
 
-    if (0 <= allocation_limit()) {
-        if (0 > m_allocation_limit_.fetch_add(-1, memory_order_relaxed) - 1) {
-            throw test_resource_exception(this, bytes, alignment);
-        }
+    if (bytes > SIZE_MAX - sizeof(AlignedHeader) - paddingSize) {
+        // The block, with its header and padding, would not fit in memory.
+        throw bad_alloc();
+    }
+
+    if (0 <= allocation_limit()) {
+        if (0 > m_allocation_limit_.fetch_add(-1, memory_order_relaxed) - 1) {
+            throw test_resource_exception(this, bytes, alignment);
+        }
+    }
+
+    test_resource_thread_record *thread = findThreadRecord(&m_threads_,
+                                                           m_serial_,
+                                                           m_pmr_);
+
+    const unsigned tag = test_resource_current_tag();
+    if (0 != tag && !m_tags_) {
+        // The per-tag table is created on the first tagged allocation.  All
+        // earlier allocations were untagged, so the resource-wide counters
+        // are exactly the counters of the "untagged" tag.
+
+        m_tags_ = static_cast<test_resource_usage *>(
+                            m_pmr_->allocate(maxTags * sizeof *m_tags_,
+                                             alignof(test_resource_usage)));
+        for (unsigned i = 0; i < maxTags; ++i) {
+            new (m_tags_ + i) test_resource_usage{};
+        }
+        m_tags_[0] = { blocks_in_use(), max_blocks(), total_blocks(),
+                       bytes_in_use(),  max_bytes(),  total_bytes() };
+    }
+
+    // Allocate the link, its call stack and its growth site before the
+    // block, so that the block is the most recent allocation from upstream,
+    // which a monotonic upstream resource can resize in place.
+
+    Link *link = addLink(m_list_, allocationIndex, m_pmr_);
+
+    link->m_bytes_ = bytes;
+    link->m_tag_   = tag;
+    if (is_capturing_stacks()) {
+        link->m_stack_ = captureStack(m_pmr_);
     }
 
-    AlignedHeader *head = (AlignedHeader *)m_pmr_->allocate(
+    GrowthSite *site = m_growth_
+                     ? prepareGrowthSite(m_growth_, link, m_pmr_)
+                     : nullptr;
+
+    AlignedHeader *head = nullptr;
+    try {
+        head = (AlignedHeader *)m_pmr_->allocate(
                                   sizeof(AlignedHeader) + bytes + paddingSize);
+    }
+    catch (...) {
+        removeLink(m_list_, link);
+        freeStack(link->m_stack_, m_pmr_);
+        m_pmr_->deallocate(link, sizeof(Link), alignof(Link));
+        throw;
+    }
     if (!head) {
         // We cannot satisfy this request.  Throw 'std::bad_alloc'.
 
+        removeLink(m_list_, link);
+        freeStack(link->m_stack_, m_pmr_);
+        m_pmr_->deallocate(link, sizeof(Link), alignof(Link));
         throw bad_alloc();
     }
 
@@ -489,10 +1414,29 @@ void *test_resource::do_allocate(size_t bytes, size_t alignment)
     m_total_bytes_.fetch_add(static_cast<long long>(bytes),
                              memory_order_relaxed);
 
-    Link *link = addLink(m_list_, allocationIndex, m_pmr_);
+    recordAllocation(&thread->m_usage_, bytes);
+    head->m_object_.m_thread_ = thread;
+
+    if (m_tags_) {
+        recordAllocation(m_tags_ + tag, bytes);
+    }
+    head->m_object_.m_tag_ = tag;
+
     head->m_object_.m_address_ = link;
     head->m_object_.m_pmr_      = this;
 
+    recordGrowthAllocation(site, link);
+
+    if (m_peak_ && m_peak_->m_bytes_ < bytes_in_use()) {
+        updatePeak(m_peak_, *m_list_,
+                   bytes_in_use(), blocks_in_use(), allocationIndex, m_pmr_);
+    }
+
+    if (m_timeline_) {
+        recordTimelineEvent(m_timeline_,
+                            allocations(), bytes_in_use(), blocks_in_use());
+    }
+
     void *address = ++head;
 
     m_last_allocated_address_.store(address, memory_order_relaxed);
@@ -623,9 +1567,22 @@ void test_resource::do_deallocate(void *p, size_t bytes, size_t alignment)
     // Now check for corrupted memory block and cross allocation.
 
     if (!miscError && !overrunBy && !underrunBy &&!paramError) {
-        m_pmr_->deallocate(removeLink(m_list_,
-                                      head->m_object_.m_address_),
-                           sizeof(Link), alignof(Link));
+        Link *link = removeLink(m_list_, head->m_object_.m_address_);
+        if (m_growth_) {
+            recordGrowthDeallocation(m_growth_, *link, allocations());
+        }
+        if (link->m_peak_) {
+            // The snapshot keeps describing the block until the next peak,
+            // and takes over its call stack.
+
+            link->m_peak_->m_link_       = nullptr;
+            link->m_peak_->m_next_freed_ = m_peak_->m_freed_;
+            m_peak_->m_freed_            = link->m_peak_;
+        }
+        else {
+            freeStack(link->m_stack_, m_pmr_);
+        }
+        m_pmr_->deallocate(link, sizeof(Link), alignof(Link));
     }
     else { // Any error, count it, report it
         if (miscError) {
@@ -670,6 +1627,28 @@ void test_resource::do_deallocate(void *p, size_t bytes, size_t alignment)
     m_bytes_in_use_.fetch_add(-static_cast<long long>(size),
                               memory_order_relaxed);
 
+    // Attribute the deallocation to the thread that allocated the block, and
+    // flag it if the block is freed by another thread: such hand-offs are
+    // where allocators contend in producer/consumer pipelines.
+
+    test_resource_thread_record *thread = head->m_object_.m_thread_;
+    recordDeallocation(&thread->m_usage_, size);
+
+    if (m_tags_) {
+        recordDeallocation(m_tags_ + head->m_object_.m_tag_, size);
+    }
+
+    const bool isCrossThread = thread->m_thread_key_ != currentThreadKey();
+    if (isCrossThread) {
+        ++thread->m_cross_thread_deallocations_;
+        m_cross_thread_deallocations_.fetch_add(1, memory_order_relaxed);
+    }
+
+    if (m_timeline_) {
+        recordTimelineEvent(m_timeline_,
+                            allocations(), bytes_in_use(), blocks_in_use());
+    }
+
     head->m_object_.m_magic_number_ = deallocatedMemoryPattern;
 
     std::memset(p, static_cast<int>(scribbledMemoryByte), size);
@@ -688,12 +1667,13 @@ void test_resource::do_deallocate(void *p, size_t bytes, size_t alignment)
                    static_cast<int>(m_name_.length()), m_name_.data());
         }
 
-        printf(" [%lld]: Deallocated %zu byte%s(aligned %zu) at %p.\n",
+        printf(" [%lld]: Deallocated %zu byte%s(aligned %zu) at %p%s.\n",
                allocationIndex,
                size,
                1 == size ? " " : "s ",
                alignment,
-               p);
+               p,
+               isCrossThread ? " (cross-thread)" : "");
 
         std::fflush(stdout);
     }
@@ -706,6 +1686,151 @@ bool test_resource::do_is_equal(const memory_resource& that) const noexcept
     return this == &that;
 }
 
+allocation_result<void *> test_resource::do_allocate_at_least(
+                                                          size_t bytes,
+                                                          size_t alignment)
+{
+    // The rounded size is recorded in the header like any other size, so
+    // deallocating with it passes the size check, and the trailing padding
+    // guards the end of the slack.
+
+    if (bytes > SIZE_MAX - (paddingSize - 1)) {
+        throw bad_alloc();
+    }
+
+    const size_t rounded = (bytes + paddingSize - 1) & ~(paddingSize - 1);
+    return { test_resource::do_allocate(rounded, alignment), rounded };
+}
+
+bool test_resource::do_try_resize(void   *p,
+                                  size_t  old_size,
+                                  size_t  new_size,
+                                  size_t  alignment)
+{
+    lock_guard guard{ m_lock_ };
+
+    if (nullptr == p) {
+        return false;                                                 // RETURN
+    }
+
+    AlignedHeader *head = (AlignedHeader *)p - 1;
+
+    // Check the block as 'do_deallocate' does, in the same order, except for
+    // the leading padding, which resizing does not touch.
+
+    bool miscError  = false;
+    bool paramError = false;
+    int  overrunBy  = 0;
+
+    if (allocatedMemoryPattern != head->m_object_.m_magic_number_ ||
+        this != head->m_object_.m_pmr_) {
+        miscError = true;
+    }
+    else {
+        byte *tail = (byte *)p + head->m_object_.m_bytes_;
+        for (byte *pc = tail; pc < tail + paddingSize; ++pc) {
+            if (paddedMemoryByte != *pc) {
+                overrunBy = static_cast<int>(pc + 1 - tail);
+                break;
+            }
+        }
+
+        if (old_size != head->m_object_.m_bytes_ ||
+            alignment != head->m_object_.m_alignment_) {
+            paramError = true;
+        }
+    }
+
+    if (miscError || paramError || overrunBy) {
+        if (miscError) {
+            m_mismatches_.fetch_add(1, memory_order_relaxed);
+        }
+        if (paramError) {
+            m_bad_deallocate_params_.fetch_add(1, memory_order_relaxed);
+        }
+        if (overrunBy) {
+            m_bounds_errors_.fetch_add(1, memory_order_relaxed);
+        }
+
+        if (!is_quiet()) {
+            formatInvalidMemoryBlock(head, old_size, alignment,
+                                     this, 0, overrunBy);
+            if (!is_no_abort()) {
+                std::abort();                                          // ABORT
+            }
+        }
+        return false;                                                 // RETURN
+    }
+
+    // The block can only change size if the upstream block does.
+
+    if (old_size != new_size &&
+        !pmr::try_resize(m_pmr_,
+                         head,
+                         sizeof(AlignedHeader) + old_size + paddingSize,
+                         sizeof(AlignedHeader) + new_size + paddingSize,
+                         alignof(max_align_t))) {
+        return false;                                                 // RETURN
+    }
+
+    // Move the trailing padding to the new end of the block.
+
+    std::memset((char *)p + new_size,
+                to_integer<unsigned char>(paddedMemoryByte), paddingSize);
+
+    head->m_object_.m_bytes_             = new_size;
+    head->m_object_.m_address_->m_bytes_ = new_size;
+
+    m_bytes_in_use_.fetch_add(static_cast<long long>(new_size) -
+                                             static_cast<long long>(old_size),
+                              memory_order_relaxed);
+    if (max_bytes() < bytes_in_use()) {
+        m_max_bytes_.store(bytes_in_use(), memory_order_relaxed);
+    }
+    if (old_size < new_size) {
+        m_total_bytes_.fetch_add(new_size - old_size, memory_order_relaxed);
+    }
+
+    recordResize(&head->m_object_.m_thread_->m_usage_, old_size, new_size);
+    if (m_tags_) {
+        recordResize(m_tags_ + head->m_object_.m_tag_, old_size, new_size);
+    }
+
+    if (head->m_object_.m_address_->m_peak_) {
+        m_peak_->m_resized_ = true;
+    }
+    if (m_peak_ && m_peak_->m_bytes_ < bytes_in_use()) {
+        updatePeak(m_peak_, *m_list_, bytes_in_use(), blocks_in_use(),
+                   allocations() - 1, m_pmr_);
+    }
+
+    if (m_timeline_) {
+        recordTimelineEvent(m_timeline_,
+                            allocations(), bytes_in_use(), blocks_in_use());
+    }
+
+    if (is_verbose()) {
+        printf("test_resource");
+
+        if (!m_name_.empty()) {
+            printf(" %.*s",
+                   static_cast<int>(m_name_.length()), m_name_.data());
+        }
+
+        printf(" [%lld]: Resized %zu byte%s(aligned %zu) at %p to %zu.\n",
+               head->m_object_.m_index_,
+               old_size,
+               1 == old_size ? " " : "s ",
+               alignment,
+               p,
+               new_size);
+
+        std::fflush(stdout);
+    }
+
+    return true;
+}
+
 void test_resource::print() const noexcept
 {
     lock_guard guard{ m_lock_ };
@@ -739,6 +1864,25 @@ void test_resource::print() const noexcept
            mismatches(),    bounds_errors(),
            bad_deallocate_params());
 
+    if ((m_threads_ && m_threads_->m_next_) || cross_thread_deallocations()) {
+        printThreadUsage(m_threads_);
+        printf("    CROSS-THREAD DEALLOCATIONS\t%lld\n"
+               "--------------------------------------------------\n",
+               cross_thread_deallocations());
+    }
+
+    if (m_tags_) {
+        printTagUsage(m_tags_, false);
+    }
+
+    if (m_peak_) {
+        printPeak(*m_peak_);
+    }
+
+    if (m_growth_) {
+        printGrowth(*m_growth_);
+    }
+
     if (m_list_->d_head_p) {
         printf(" Indices of Outstanding Memory Allocations:\n ");
         printList(*m_list_);
@@ -746,6 +1890,299 @@ void test_resource::print() const noexcept
     std::fflush(stdout);
 }
 
+long long test_resource::thread_count() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    long long count = 0;
+    for (const test_resource_thread_record *record = m_threads_;
+         record;
+         record = record->m_next_) {
+        ++count;
+    }
+    return count;
+}
+
+test_resource_thread_usage test_resource::thread_usage(long long index) const
+                                                                       noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    for (const test_resource_thread_record *record = m_threads_;
+         record;
+         record = record->m_next_) {
+        if (record->m_ordinal_ == index) {
+            return { record->m_thread_id_,
+                     record->m_usage_,
+                     record->m_cross_thread_deallocations_ };         // RETURN
+        }
+    }
+    return {};
+}
+
+test_resource_thread_usage test_resource::this_thread_usage() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    const unsigned long long key = currentThreadKey();
+
+    for (const test_resource_thread_record *record = m_threads_;
+         record;
+         record = record->m_next_) {
+        if (record->m_thread_key_ == key) {
+            return { record->m_thread_id_,
+                     record->m_usage_,
+                     record->m_cross_thread_deallocations_ };         // RETURN
+        }
+    }
+    return { this_thread::get_id(), {}, 0 };
+}
+
+void test_resource::set_track_peak(bool is_tracking)
+{
+    lock_guard guard{ m_lock_ };
+
+    if (!is_tracking) {
+        if (m_peak_) {
+            destroyPeak(m_peak_, m_pmr_);
+            m_peak_ = nullptr;
+        }
+        return;                                                       // RETURN
+    }
+
+    if (m_peak_) {
+        return;                                                       // RETURN
+    }
+
+    m_peak_ = static_cast<test_resource_peak *>(
+                            m_pmr_->allocate(sizeof(test_resource_peak),
+                                             alignof(test_resource_peak)));
+    *m_peak_ = { nullptr, nullptr, nullptr, -1, 0, 0, false };
+
+    updatePeak(m_peak_, *m_list_, bytes_in_use(), blocks_in_use(),
+               allocations() - 1, m_pmr_);
+}
+
+bool test_resource::is_tracking_peak() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    return nullptr != m_peak_;
+}
+
+long long test_resource::peak_bytes() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    return m_peak_ ? m_peak_->m_bytes_ : 0;
+}
+
+long long test_resource::peak_blocks(test_resource_block *blocks,
+                                     long long            capacity) const
+                                                                       noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    if (!m_peak_) {
+        return 0;                                                     // RETURN
+    }
+
+    long long count = 0;
+    for (const PeakRecord *record = m_peak_->m_head_;
+         record && count < capacity;
+         record = record->m_next_, ++count) {
+        test_resource_block& block = blocks[count];
+
+        block.index       = record->m_index_;
+        block.bytes       = record->m_bytes_;
+        block.tag         = record->m_tag_;
+        block.frame_count = 0;
+        if (record->m_stack_) {
+            block.frame_count = record->m_stack_->m_depth_;
+            copy(record->m_stack_->m_frames_,
+                 record->m_stack_->m_frames_ + block.frame_count,
+                 block.frames);
+        }
+    }
+    return m_peak_->m_blocks_;
+}
+
+void test_resource::print_peak() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    if (m_peak_) {
+        printPeak(*m_peak_);
+    }
+    std::fflush(stdout);
+}
+
+void test_resource::set_timeline(size_t capacity)
+{
+    lock_guard guard{ m_lock_ };
+
+    if (m_timeline_) {
+        destroyTimeline(m_timeline_, m_pmr_);
+        m_timeline_ = nullptr;
+    }
+
+    if (0 == capacity) {
+        return;                                                       // RETURN
+    }
+
+    // Merging needs a pair of samples to make room for the next one.
+
+    capacity = max(capacity, size_t(2));
+
+    m_timeline_ = static_cast<test_resource_timeline *>(
+                    m_pmr_->allocate(sizeof(test_resource_timeline) +
+                                             capacity * sizeof(TimelineSample),
+                                     alignof(test_resource_timeline)));
+    *m_timeline_ = { capacity, 0, 1, 0, bytes_in_use(),
+                     chrono::steady_clock::now() };
+}
+
+size_t test_resource::timeline_size() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    return m_timeline_ ? m_timeline_->m_size_ : 0;
+}
+
+void test_resource::print_timeline_csv(FILE *stream) const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    fprintf(stream, "event,allocations,time_ns,bytes_in_use,blocks_in_use,"
+                    "max_bytes_in_use\n");
+
+    if (m_timeline_) {
+        const TimelineSample *samples = m_timeline_->samples();
+        for (size_t i = 0; i < m_timeline_->m_size_; ++i) {
+            fprintf(stream, "%lld,%lld,%lld,%lld,%lld,%lld\n",
+                    samples[i].m_event_,
+                    samples[i].m_allocations_,
+                    samples[i].m_nanoseconds_,
+                    samples[i].m_bytes_,
+                    samples[i].m_blocks_,
+                    samples[i].m_max_bytes_);
+        }
+    }
+    fflush(stream);
+}
+
+void test_resource::set_track_growth(bool is_tracking)
+{
+    lock_guard guard{ m_lock_ };
+
+    if (!is_tracking) {
+        if (m_growth_) {
+            destroyGrowth(m_growth_, m_pmr_);
+            m_growth_ = nullptr;
+        }
+        return;                                                       // RETURN
+    }
+
+    if (m_growth_) {
+        return;                                                       // RETURN
+    }
+
+    m_growth_ = static_cast<test_resource_growth *>(
+                          m_pmr_->allocate(sizeof(test_resource_growth),
+                                           alignof(test_resource_growth)));
+    m_growth_->m_reallocations_ = 0;
+    m_growth_->m_bytes_copied_  = 0;
+    for (GrowthSite& site : m_growth_->m_sites_) {
+        site.m_key_ = 0;
+    }
+
+    // Blocks allocated before tracking started belong to no site.
+
+    for (Link *link = m_list_->d_head_p; link; link = link->m_next_) {
+        link->m_site_ = 0;
+    }
+}
+
+long long test_resource::growth_reallocations() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    return m_growth_ ? m_growth_->m_reallocations_ : 0;
+}
+
+long long test_resource::growth_bytes_copied() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    return m_growth_ ? m_growth_->m_bytes_copied_ : 0;
+}
+
+long long test_resource::growth_sites(test_resource_growth_site *sites,
+                                      long long                  capacity)
+                                                                 const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    if (!m_growth_) {
+        return 0;                                                     // RETURN
+    }
+
+    const GrowthSite *sorted[maxGrowthSites];
+    const int         count = sortedGrowthSites(*m_growth_, sorted);
+
+    for (long long i = 0; i < count && i < capacity; ++i) {
+        test_resource_growth_site& site = sites[i];
+
+        site.tag           = sorted[i]->m_tag_;
+        site.reallocations = sorted[i]->m_reallocations_;
+        site.bytes_copied  = sorted[i]->m_bytes_copied_;
+        site.longest_chain = sorted[i]->m_longest_chain_;
+        site.largest_bytes = sorted[i]->m_largest_bytes_;
+        site.frame_count   = 0;
+        if (sorted[i]->m_stack_) {
+            site.frame_count = sorted[i]->m_stack_->m_depth_;
+            copy(sorted[i]->m_stack_->m_frames_,
+                 sorted[i]->m_stack_->m_frames_ + site.frame_count,
+                 site.frames);
+        }
+    }
+    return count;
+}
+
+void test_resource::print_growth() const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    if (m_growth_) {
+        printGrowth(*m_growth_);
+    }
+    std::fflush(stdout);
+}
+
+test_resource_usage test_resource::tag_usage(unsigned tag) const noexcept
+{
+    lock_guard guard{ m_lock_ };
+
+    if (tag >= maxTags) {
+        return {};                                                    // RETURN
+    }
+    if (!m_tags_) {
+        return 0 == tag ? test_resource_usage{ blocks_in_use(),
+                                               max_blocks(),
+                                               total_blocks(),
+                                               bytes_in_use(),
+                                               max_bytes(),
+                                               total_bytes() }
+                        : test_resource_usage{};                      // RETURN
+    }
+    return m_tags_[tag];
+}
+
+test_resource_usage test_resource::tag_usage(string_view label) const noexcept
+{
+    return tag_usage(test_resource_tag_id(label));
+}
+
 long long test_resource::status() const noexcept
 {
     static const int memoryLeak = -1;
@@ -0,0 +1,67 @@
+// stopwatch.h                                                        -*-C++-*-
+#ifndef SUPPORTLIB_STOPWATCH_H_INCLUDED
+#define SUPPORTLIB_STOPWATCH_H_INCLUDED
+
+#include <chrono>
+#include <cstdio>
+
+struct Stopwatch {
+    // Measure the wall time elapsed since construction (or 'restart').
+
+    Stopwatch()
+    : m_start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    void restart()
+    {
+        m_start_ = std::chrono::steady_clock::now();
+    }
+
+    double elapsed_ns() const
+    {
+        return std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - m_start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start_;
+};
+
+inline
+void report(const char *name, double elapsedNs, long long iterations)
+    // Print the specified 'name' of a measurement and the time per iteration
+    // from the specified 'elapsedNs' for 'iterations'.
+{
+    std::printf("%-40s %10.2f ns/op\n", name, elapsedNs / iterations);
+}
+
+template <class TYPE>
+inline
+void do_not_optimize(const TYPE& value)
+    // Make the optimizer believe the specified 'value' is used.
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static_cast<const volatile TYPE&>(value);
+#endif
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Copyright 2019 Bloomberg Finance L.P.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------- END-OF-FILE ----------------------------------